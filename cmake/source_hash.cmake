@@ -0,0 +1,14 @@
+# cmake -DOUTPUT=<header> -DSOURCES=<files> -P source_hash.cmake
+# writes the hash of the sources' contents into <header> as AOC_SOURCE_HASH
+list(SORT SOURCES)
+set(hashes "")
+foreach(source IN LISTS SOURCES)
+  file(SHA256 ${source} hash)
+  string(APPEND hashes ${hash})
+endforeach()
+string(SHA256 hash "${hashes}")
+string(SUBSTRING ${hash} 0 16 hash)
+file(WRITE ${OUTPUT}
+"// generated by source_hash.cmake, do not edit
+#define AOC_SOURCE_HASH \"${hash}\"
+")
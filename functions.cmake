@@ -48,6 +48,10 @@ target_compile_options(sanitizer_options INTERFACE
     $<$<CONFIG:PROFILE>:-g -O1>
     $<$<CONFIG:HEAP>:-g -O1>)
 
+# the PROFILE config only profiles the scopes of a ScopedProfiler
+target_compile_definitions(sanitizer_options INTERFACE
+    $<$<CONFIG:PROFILE>:AOC_PROFILE>)
+
 target_link_options(sanitizer_options INTERFACE
   $<$<CONFIG:ASAN>:-fsanitize=address>
   $<$<CONFIG:MSAN>:-fsanitize=memory -pie>
@@ -60,5 +64,33 @@ function(add_aoc_target target)
   if(EXISTS src/${target}.cpp)
     add_executable(${target} src/${target}.cpp)
     target_link_libraries(${target} PRIVATE utility compilation_options sanitizer_options libassert::assert BS_thread_pool)
+    target_sources(solvers PRIVATE src/${target}.cpp)
   endif()
 endfunction()
+
+# the target's input, embedded into a generated header and solved at compile
+# time into a ${target}_embedded binary (see AOC_EMBED_INPUT_DIR)
+function(add_aoc_embedded_target target input)
+  set(header ${CMAKE_BINARY_DIR}/embedded/${target}_input.hpp)
+  file(READ ${input} bytes HEX)
+  string(REGEX REPLACE "([0-9a-f][0-9a-f])" "'\\\\x\\1'," bytes "${bytes}")
+  file(CONFIGURE OUTPUT ${header} CONTENT
+"// generated from ${input}, do not edit
+#include <string_view> // std::string_view
+
+inline constexpr char EMBEDDED_INPUT_DATA[]{${bytes}'\\0'};
+inline constexpr std::string_view EMBEDDED_INPUT{
+    EMBEDDED_INPUT_DATA, sizeof(EMBEDDED_INPUT_DATA) - 1};
+")
+  # a changed input regenerates the header
+  set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${input})
+
+  add_executable(${target}_embedded src/${target}.cpp)
+  target_compile_definitions(${target}_embedded PRIVATE
+      AOC_NO_MAIN "AOC_EMBED_INPUT=\"${header}\"")
+  # a whole input takes far more steps than the default limits allow
+  target_compile_options(${target}_embedded PRIVATE
+      $<$<CXX_COMPILER_ID:GNU>:-fconstexpr-ops-limit=4294967296 -fconstexpr-loop-limit=16777216>
+      $<$<CXX_COMPILER_ID:Clang>:-fconstexpr-steps=4294967295>)
+  target_link_libraries(${target}_embedded PRIVATE utility compilation_options sanitizer_options libassert::assert BS_thread_pool)
+endfunction()
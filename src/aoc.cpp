@@ -0,0 +1,98 @@
+#include "memory_stats.hpp" // print_memory_stats
+#include "result_cache.hpp" // cached_solve
+#include "solver.hpp" // get_solvers
+#include "task_scheduler.hpp" // TaskGroup
+#include "utility.hpp"
+
+#include <chrono> // std::chrono::steady_clock
+#include <format> // std::format
+#include <print> // std::println
+#include <span> // std::span
+#include <string> // std::string
+#include <vector> // std::vector
+
+namespace
+{
+struct RunResult
+{
+  Solver const *m_solver;
+  std::string m_answer;
+  std::chrono::nanoseconds m_elapsed;
+};
+
+RunResult
+run_solver(Solver const &solver, char const *input_dir);
+} // namespace
+
+/// Runs every registered solver (or only the selected days, e.g. `5` or
+/// `d05p2`) on `<input_dir>/dNN.txt`, each one as a task on the shared
+/// scheduler, and prints the answers followed by the scheduler's and the
+/// process's memory stats.
+int
+main(int argc, char const **argv) {
+  auto args = std::span(argv, std::size_t(argc));
+  if (args.size() < 2) {
+    std::println(stderr, "usage: {} input_dir [day|dNNpM...]", args[0]);
+    return 1;
+  }
+  auto const selection = args.subspan(2);
+  start_memory_watchdog();
+
+  std::vector<RunResult> results;
+  for (Solver const &solver : get_solvers()) {
+    if (is_selected(solver, selection)) {
+      results.emplace_back(&solver, "", std::chrono::nanoseconds{});
+    }
+  }
+
+  TaskScheduler &scheduler = default_scheduler();
+  auto const start = std::chrono::steady_clock::now();
+  {
+    TaskGroup group(scheduler);
+    for (RunResult &result : results) {
+      group.spawn([&result, input_dir = args[1]] {
+        result = run_solver(*result.m_solver, input_dir);
+      });
+    }
+    group.wait();
+  }
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+
+  for (RunResult const &result : results) {
+    std::println("{} {:>20} {:>12.3f} ms",
+                 get_solver_name(*result.m_solver),
+                 result.m_answer,
+                 static_cast<double>(result.m_elapsed.count()) / 1e6);
+  }
+  std::println(stderr,
+               "total: {:.3f} ms",
+               static_cast<double>(
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                       .count())
+                   / 1e6);
+  scheduler.print_stats(stderr);
+  if (ResultCache const *cache = default_result_cache()) {
+    cache->print_stats(stderr);
+  }
+  print_memory_stats(stderr);
+  return 0;
+}
+
+namespace
+{
+RunResult
+run_solver(Solver const &solver, char const *input_dir) {
+  solver.m_tests();
+  std::string const path =
+      std::format("{}/d{:02}.txt", input_dir, solver.m_day);
+
+  // reading the input is timed too, as days with a cached model skip parsing
+  auto const start = std::chrono::steady_clock::now();
+  std::string answer =
+      cached_solve_file(solver, path.c_str()).value_or(std::string("-"));
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+  return {.m_solver = &solver,
+          .m_answer = std::move(answer),
+          .m_elapsed = elapsed};
+}
+} // namespace
@@ -0,0 +1,209 @@
+#include "aoc_api.h"
+#include "decompression.hpp" // decompress
+#include "solver.hpp" // find_solver, throw_on_solver_failures
+#include "utility.hpp" // split_lines
+
+#include <chrono> // std::chrono::steady_clock
+#include <cstring> // std::memcpy
+#include <memory> // std::make_unique
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <vector> // std::vector
+
+struct aoc_input
+{
+  std::vector<std::string> m_lines;
+  u64 m_num_bytes;
+};
+
+namespace
+{
+/// the input's lines, decompressed first if need be; each line is copied out
+/// of the buffer, which m_solve's lines can't refer to
+aoc_status
+parse_input(std::string_view buffer, aoc_input &input);
+Solver const *
+get_solver(int day, int part);
+aoc_status
+solve(Solver const &solver, aoc_input const &input, aoc_result &result);
+aoc_status
+set_status(aoc_result *result, aoc_status status);
+u64
+to_ns(std::chrono::steady_clock::duration duration);
+
+/// a malformed input fails the solver's assertions, which must fail the call
+/// with AOC_ERROR_SOLVER_FAILED rather than abort the host
+[[maybe_unused]] bool const throws_on_solver_failures = [] {
+  throw_on_solver_failures();
+  return true;
+}();
+} // namespace
+
+// no exception may cross the C ABI: every entry point catches them all
+
+int
+aoc_api_version(void) {
+  return AOC_API_VERSION;
+}
+
+int
+aoc_has_solver(int day, int part) {
+  return get_solver(day, part) != nullptr ? 1 : 0;
+}
+
+char const *
+aoc_status_string(aoc_status status) {
+  switch (status) {
+  case AOC_OK:
+    return "ok";
+  case AOC_ERROR_INVALID_ARGUMENT:
+    return "invalid argument";
+  case AOC_ERROR_UNKNOWN_SOLVER:
+    return "unknown solver";
+  case AOC_ERROR_EMPTY_INPUT:
+    return "empty input";
+  case AOC_ERROR_CORRUPT_INPUT:
+    return "corrupt compressed input";
+  case AOC_ERROR_ANSWER_TOO_LONG:
+    return "answer too long";
+  case AOC_ERROR_SOLVER_FAILED:
+    return "solver failed";
+  }
+  return "unknown status";
+}
+
+aoc_status
+aoc_solve(int day, int part, char const *buf, size_t len, aoc_result *result) {
+  if (result == nullptr) {
+    return AOC_ERROR_INVALID_ARGUMENT;
+  }
+  if (buf == nullptr && len != 0) {
+    return set_status(result, AOC_ERROR_INVALID_ARGUMENT);
+  }
+  Solver const *solver = get_solver(day, part);
+  if (solver == nullptr) {
+    return set_status(result, AOC_ERROR_UNKNOWN_SOLVER);
+  }
+  try {
+    aoc_input input{};
+    auto const start = std::chrono::steady_clock::now();
+    if (aoc_status const status = parse_input({buf, len}, input);
+        status != AOC_OK) {
+      return set_status(result, status);
+    }
+    u64 const parse_ns = to_ns(std::chrono::steady_clock::now() - start);
+    aoc_status const status = solve(*solver, input, *result);
+    result->stats.parse_ns = parse_ns;
+    return status;
+  } catch (...) {
+    return set_status(result, AOC_ERROR_SOLVER_FAILED);
+  }
+}
+
+aoc_status
+aoc_input_create(char const *buf, size_t len, aoc_input **input) {
+  if (input == nullptr) {
+    return AOC_ERROR_INVALID_ARGUMENT;
+  }
+  *input = nullptr;
+  if (buf == nullptr && len != 0) {
+    return AOC_ERROR_INVALID_ARGUMENT;
+  }
+  try {
+    auto parsed = std::make_unique<aoc_input>();
+    if (aoc_status const status = parse_input({buf, len}, *parsed);
+        status != AOC_OK) {
+      return status;
+    }
+    *input = parsed.release();
+    return AOC_OK;
+  } catch (...) {
+    return AOC_ERROR_SOLVER_FAILED;
+  }
+}
+
+aoc_status
+aoc_solve_input(int day,
+                int part,
+                aoc_input const *input,
+                aoc_result *result) {
+  if (result == nullptr) {
+    return AOC_ERROR_INVALID_ARGUMENT;
+  }
+  if (input == nullptr) {
+    return set_status(result, AOC_ERROR_INVALID_ARGUMENT);
+  }
+  Solver const *solver = get_solver(day, part);
+  if (solver == nullptr) {
+    return set_status(result, AOC_ERROR_UNKNOWN_SOLVER);
+  }
+  try {
+    return solve(*solver, *input, *result);
+  } catch (...) {
+    return set_status(result, AOC_ERROR_SOLVER_FAILED);
+  }
+}
+
+void
+aoc_input_destroy(aoc_input *input) {
+  delete input;
+}
+
+namespace
+{
+aoc_status
+parse_input(std::string_view buffer, aoc_input &input) {
+  input.m_num_bytes = buffer.size();
+  Compression const compression = detect_compression(buffer);
+  if (compression == Compression::NONE) {
+    input.m_lines = split_lines(buffer);
+  } else {
+    std::string contents;
+    if (!decompress(buffer, compression, contents)) {
+      return AOC_ERROR_CORRUPT_INPUT;
+    }
+    input.m_lines = split_lines(contents);
+  }
+  return input.m_lines.empty() ? AOC_ERROR_EMPTY_INPUT : AOC_OK;
+}
+
+Solver const *
+get_solver(int day, int part) {
+  if (day < 1 || day > 25 || part < 1 || part > 2) {
+    return nullptr;
+  }
+  return find_solver(static_cast<std::uint8_t>(day),
+                     static_cast<std::uint8_t>(part));
+}
+
+aoc_status
+solve(Solver const &solver, aoc_input const &input, aoc_result &result) {
+  result = aoc_result{};
+  result.stats.input_bytes = input.m_num_bytes;
+  result.stats.num_lines = input.m_lines.size();
+  auto const start = std::chrono::steady_clock::now();
+  std::string const answer = solver.m_solve(input.m_lines);
+  result.stats.solve_ns = to_ns(std::chrono::steady_clock::now() - start);
+  if (answer.size() >= AOC_MAX_ANSWER_SIZE) {
+    result.status = AOC_ERROR_ANSWER_TOO_LONG;
+    return result.status;
+  }
+  std::memcpy(result.answer, answer.data(), answer.size());
+  result.answer[answer.size()] = '\0';
+  result.status = AOC_OK;
+  return result.status;
+}
+
+aoc_status
+set_status(aoc_result *result, aoc_status status) {
+  *result = aoc_result{};
+  result->status = status;
+  return status;
+}
+
+u64
+to_ns(std::chrono::steady_clock::duration duration) {
+  return static_cast<u64>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+} // namespace
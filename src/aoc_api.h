@@ -0,0 +1,98 @@
+#ifndef AOC_API_H
+#define AOC_API_H
+
+/* The solvers behind a stable C ABI, for calling them in-process instead of
+ * running a dNNpM binary per input.
+ *
+ * The input is NOT solved in place: the solvers take their input as lines
+ * they own, so every call copies each line of the buffer (decompressing a
+ * gzip or zstd compressed one first). A call thus costs about one copy of
+ * the input, which aoc_input_create() pays once for any number of solves.
+ *
+ * Every function may be called from any number of threads at once. The input
+ * is a whole input file held in memory. A malformed input for the day fails
+ * the solver's assertions, which the library reports as
+ * AOC_ERROR_SOLVER_FAILED rather than aborting the process as the binaries
+ * do: loading it makes every failed assertion in it throw. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bumped on every incompatible change of the functions and structs below */
+#define AOC_API_VERSION 1
+
+#define AOC_MAX_ANSWER_SIZE 128
+
+typedef enum aoc_status
+{
+  AOC_OK = 0,
+  AOC_ERROR_INVALID_ARGUMENT = 1,
+  AOC_ERROR_UNKNOWN_SOLVER = 2,
+  AOC_ERROR_EMPTY_INPUT = 3,
+  AOC_ERROR_CORRUPT_INPUT = 4,
+  AOC_ERROR_ANSWER_TOO_LONG = 5,
+  AOC_ERROR_SOLVER_FAILED = 6
+} aoc_status;
+
+/* what a single call did */
+typedef struct aoc_stats
+{
+  /* splitting the buffer into lines, and decompressing it if needed; 0 when
+   * solving an aoc_input, which was parsed when it was created */
+  uint64_t parse_ns;
+  uint64_t solve_ns;
+  uint64_t input_bytes;
+  uint64_t num_lines;
+} aoc_stats;
+
+typedef struct aoc_result
+{
+  aoc_status status;
+  /* NUL-terminated; empty unless status is AOC_OK */
+  char answer[AOC_MAX_ANSWER_SIZE];
+  aoc_stats stats;
+} aoc_result;
+
+/* an input parsed once, to be solved by any number of solvers */
+typedef struct aoc_input aoc_input;
+
+/* AOC_API_VERSION of the library actually loaded */
+int
+aoc_api_version(void);
+
+/* whether there's a solver for the day's part */
+int
+aoc_has_solver(int day, int part);
+
+/* a static description of the status, e.g. "unknown solver" */
+char const *
+aoc_status_string(aoc_status status);
+
+/* solve the input in `buf[0, len)`; the status is also stored in `result` */
+aoc_status
+aoc_solve(int day, int part, char const *buf, size_t len, aoc_result *result);
+
+/* parse the input in `buf[0, len)` once; `buf` may be released as soon as
+ * this returns. Stores NULL into `input` on failure. */
+aoc_status
+aoc_input_create(char const *buf, size_t len, aoc_input **input);
+
+/* like aoc_solve(), on an input parsed already */
+aoc_status
+aoc_solve_input(int day,
+                int part,
+                aoc_input const *input,
+                aoc_result *result);
+
+void
+aoc_input_destroy(aoc_input *input);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AOC_API_H */
@@ -0,0 +1,82 @@
+#include "protocol.hpp" // connect_unix
+#include "utility.hpp"
+
+#include <charconv> // std::from_chars
+#include <optional> // std::optional
+#include <print> // std::println
+#include <span> // std::span
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <system_error> // std::errc
+
+namespace
+{
+/// the day or part `sv` names: nullopt unless it's all digits and fits a u8
+std::optional<u8>
+parse_u8(std::string_view sv);
+} // namespace
+
+/// Sends one request to aocd and prints the answer, like a dNNpM executable
+/// would. With --inline the input is sent over the socket instead of by path,
+/// for a daemon that can't read the client's files.
+int
+main(int argc, char const **argv) {
+  auto args = std::span(argv, std::size_t(argc));
+  bool const is_inline =
+      args.size() == 6 && args[5] == std::string_view{"--inline"};
+  std::optional<u8> day;
+  std::optional<u8> part;
+  if (args.size() == 5 || is_inline) {
+    day = parse_u8(args[2]);
+    part = parse_u8(args[3]);
+  }
+  if (!day || !part) {
+    std::println(
+        stderr, "usage: {} socket_path day part input.txt [--inline]", args[0]);
+    return 1;
+  }
+
+  Request request{.m_day = *day,
+                  .m_part = *part,
+                  .m_inline = is_inline,
+                  .m_input = args[4]};
+  if (is_inline && !read_file(args[4], request.m_input)) {
+    std::println(stderr, "couldn't open {}", args[4]);
+    return 1;
+  }
+
+  std::optional<Connection> connection = connect_unix(args[1]);
+  if (!connection) {
+    std::println(stderr, "couldn't connect to {}", args[1]);
+    return 1;
+  }
+  if (!connection->send_request(request)) {
+    std::println(stderr, "couldn't send the request");
+    return 1;
+  }
+  std::optional<Response> const response = connection->receive_response();
+  if (!response) {
+    std::println(stderr, "no response");
+    return 1;
+  }
+  if (!response->m_ok) {
+    std::println(stderr, "error: {}", response->m_answer);
+    return 1;
+  }
+  std::println("{}", response->m_answer);
+  std::println(stderr, "solved in {} us", response->m_time_us);
+  return 0;
+}
+
+namespace
+{
+std::optional<u8>
+parse_u8(std::string_view sv) {
+  u8 value{};
+  auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), value);
+  if (ec != std::errc() || ptr != sv.data() + sv.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+} // namespace
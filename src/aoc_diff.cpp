@@ -0,0 +1,201 @@
+#include "solver.hpp" // get_solvers
+#include "utility.hpp"
+
+#include <algorithm> // std::ranges::all_of
+#include <chrono> // std::chrono::steady_clock
+#include <optional> // std::optional
+#include <print> // std::println
+#include <random> // std::mt19937_64
+#include <span> // std::span
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <vector> // std::vector
+
+namespace
+{
+struct DiffOptions
+{
+  u64 m_seed;
+  std::size_t m_num_cases;
+  std::size_t m_max_size;
+  std::span<char const *const> m_selection;
+};
+
+/// a generated input on which the solve and the reference disagree
+struct Mismatch
+{
+  u64 m_case_idx;
+  std::size_t m_size;
+  std::vector<std::string> m_lines;
+  std::string m_answer;
+  std::string m_reference_answer;
+};
+
+/// the cases the shrinking tries per size, below the failing case's size
+constexpr std::size_t NUM_SHRINK_CASES{200};
+/// past the case indices of the regular cases, so they aren't tried again
+constexpr u64 SHRINK_CASES_BASE{u64{1} << 32};
+
+std::optional<DiffOptions>
+parse_options(std::span<char const *const> args);
+std::vector<std::string>
+generate_case(Solver const &solver,
+              u64 seed,
+              u64 case_idx,
+              std::size_t size);
+std::optional<Mismatch>
+check_case(Solver const &solver, u64 seed, u64 case_idx, std::size_t size);
+Mismatch
+shrink(Solver const &solver, u64 seed, Mismatch mismatch);
+void
+print_mismatch(Solver const &solver, u64 seed, Mismatch const &mismatch);
+} // namespace
+
+/// Differential testing of the optimized solvers: every solver with both a
+/// reference and an input generator solves `cases` random inputs, of sizes
+/// cycling up to `max-size`, with both its solve and its reference. The first
+/// disagreement is shrunk to the smallest input still disagreeing that the
+/// generator gives, which is printed along with the way to reproduce it.
+int
+main(int argc, char const **argv) {
+  auto args = std::span(argv, std::size_t(argc));
+  std::optional<DiffOptions> const options = parse_options(args.subspan(1));
+  if (!options) {
+    std::println(stderr,
+                 "usage: {} [--seed N] [--cases N] [--max-size N] "
+                 "[day|dNNpM...]",
+                 args[0]);
+    return 1;
+  }
+
+  int ret_val = 0;
+  for (Solver const &solver : get_solvers()) {
+    if (!solver.m_reference || !solver.m_generate
+        || !is_selected(solver, options->m_selection)) {
+      continue;
+    }
+    solver.m_tests();
+
+    auto const start = std::chrono::steady_clock::now();
+    std::optional<Mismatch> mismatch;
+    for (u64 case_idx = 0; case_idx < options->m_num_cases && !mismatch;
+         ++case_idx) {
+      std::size_t const size = 1 + (case_idx % options->m_max_size);
+      mismatch = check_case(solver, options->m_seed, case_idx, size);
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    if (mismatch) {
+      print_mismatch(
+          solver,
+          options->m_seed,
+          shrink(solver, options->m_seed, *std::move(mismatch)));
+      ret_val = 1;
+      continue;
+    }
+    std::println("{}: {} cases agree ({:.3f} ms)",
+                 get_solver_name(solver),
+                 options->m_num_cases,
+                 static_cast<double>(
+                     std::chrono::duration_cast<std::chrono::microseconds>(
+                         elapsed)
+                         .count())
+                     / 1e3);
+  }
+  return ret_val;
+}
+
+namespace
+{
+std::optional<DiffOptions>
+parse_options(std::span<char const *const> args) {
+  DiffOptions options{.m_seed = 1,
+                      .m_num_cases = 2000,
+                      .m_max_size = 50,
+                      .m_selection = {}};
+  std::size_t idx = 0;
+  for (; idx < args.size() && std::string_view(args[idx]).starts_with("--");
+       ++idx) {
+    std::string_view const option{args[idx]};
+    if (idx + 1 == args.size()
+        || !std::ranges::all_of(std::string_view{args[idx + 1]}, is_digit)) {
+      return std::nullopt;
+    }
+    u64 const value = str_to_int<u64>(args[++idx]);
+    if (option == "--seed") {
+      options.m_seed = value;
+    } else if (option == "--cases" && value > 0) {
+      options.m_num_cases = value;
+    } else if (option == "--max-size" && value > 0) {
+      options.m_max_size = value;
+    } else {
+      return std::nullopt;
+    }
+  }
+  options.m_selection = args.subspan(idx);
+  return options;
+}
+
+/// the same input for the same seed, solver, case and size, whatever the
+/// cases that ran before
+std::vector<std::string>
+generate_case(Solver const &solver,
+              u64 seed,
+              u64 case_idx,
+              std::size_t size) {
+  std::seed_seq seed_seq{static_cast<u32>(seed),
+                         static_cast<u32>(seed >> 32),
+                         static_cast<u32>(solver.m_day),
+                         static_cast<u32>(solver.m_part),
+                         static_cast<u32>(case_idx),
+                         static_cast<u32>(case_idx >> 32),
+                         static_cast<u32>(size)};
+  std::mt19937_64 rng(seed_seq);
+  return solver.m_generate(rng, size);
+}
+
+std::optional<Mismatch>
+check_case(Solver const &solver, u64 seed, u64 case_idx, std::size_t size) {
+  std::vector<std::string> lines = generate_case(solver, seed, case_idx, size);
+  std::string answer = solver.m_solve(lines);
+  std::string reference_answer = solver.m_reference(lines);
+  if (answer == reference_answer) {
+    return std::nullopt;
+  }
+  return Mismatch{.m_case_idx = case_idx,
+                  .m_size = size,
+                  .m_lines = std::move(lines),
+                  .m_answer = std::move(answer),
+                  .m_reference_answer = std::move(reference_answer)};
+}
+
+/// the generator's size is what the shrinking reduces: the smallest size at
+/// which any of a few hundred cases still disagrees
+Mismatch
+shrink(Solver const &solver, u64 seed, Mismatch mismatch) {
+  for (std::size_t size = 1; size < mismatch.m_size; ++size) {
+    for (u64 idx = 0; idx < NUM_SHRINK_CASES; ++idx) {
+      if (std::optional<Mismatch> smaller =
+              check_case(solver, seed, SHRINK_CASES_BASE + idx, size)) {
+        return *std::move(smaller);
+      }
+    }
+  }
+  return mismatch;
+}
+
+void
+print_mismatch(Solver const &solver, u64 seed, Mismatch const &mismatch) {
+  std::println("{}: case {} of size {} (--seed {}) disagrees: {} but the "
+               "reference gives {}, on",
+               get_solver_name(solver),
+               mismatch.m_case_idx,
+               mismatch.m_size,
+               seed,
+               mismatch.m_answer,
+               mismatch.m_reference_answer);
+  for (std::string const &line : mismatch.m_lines) {
+    std::println("  {}", line);
+  }
+}
+} // namespace
@@ -0,0 +1,161 @@
+#include "protocol.hpp" // connect_unix
+#include "utility.hpp"
+
+#include <algorithm> // std::ranges::sort
+#include <atomic> // std::atomic
+#include <chrono> // std::chrono::steady_clock
+#include <optional> // std::optional
+#include <print> // std::println
+#include <span> // std::span
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <thread> // std::jthread
+#include <vector> // std::vector
+
+namespace
+{
+struct LoadOptions
+{
+  std::string m_socket_path;
+  Request m_request;
+  std::size_t m_num_clients;
+  std::size_t m_num_requests;
+};
+
+std::optional<LoadOptions>
+parse_options(std::span<char const *const> args);
+void
+print_latencies(std::vector<std::chrono::nanoseconds> &latencies,
+                std::chrono::nanoseconds elapsed);
+} // namespace
+
+/// Load generator for aocd: `clients` threads, each with one persistent
+/// connection, send `requests` requests back to back, then the throughput and
+/// the latency percentiles seen by the clients are printed.
+int
+main(int argc, char const **argv) {
+  auto args = std::span(argv, std::size_t(argc));
+  std::optional<LoadOptions> const options = parse_options(args.subspan(1));
+  if (!options) {
+    std::println(stderr,
+                 "usage: {} socket_path day part input.txt [--clients N] "
+                 "[--requests N] [--inline]",
+                 args[0]);
+    return 1;
+  }
+
+  std::vector<std::vector<std::chrono::nanoseconds>> client_latencies(
+      options->m_num_clients);
+  std::atomic<std::size_t> num_errors{0};
+  auto const start = std::chrono::steady_clock::now();
+  {
+    std::vector<std::jthread> clients;
+    for (auto &latencies : client_latencies) {
+      clients.emplace_back([&] {
+        std::optional<Connection> connection =
+            connect_unix(options->m_socket_path);
+        if (!connection) {
+          num_errors.fetch_add(options->m_num_requests);
+          return;
+        }
+        latencies.reserve(options->m_num_requests);
+        for (std::size_t idx = 0; idx < options->m_num_requests; ++idx) {
+          auto const request_start = std::chrono::steady_clock::now();
+          std::optional<Response> response;
+          if (connection->send_request(options->m_request)) {
+            response = connection->receive_response();
+          }
+          if (!response || !response->m_ok) {
+            num_errors.fetch_add(1);
+            continue;
+          }
+          latencies.push_back(std::chrono::steady_clock::now() - request_start);
+        }
+      });
+    }
+  }
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+
+  std::vector<std::chrono::nanoseconds> latencies;
+  for (auto const &client : client_latencies) {
+    latencies.insert(latencies.end(), client.begin(), client.end());
+  }
+  if (num_errors.load() != 0) {
+    std::println(stderr, "{} requests failed", num_errors.load());
+  }
+  if (latencies.empty()) {
+    return 1;
+  }
+  print_latencies(latencies, elapsed);
+  return num_errors.load() == 0 ? 0 : 1;
+}
+
+namespace
+{
+std::optional<LoadOptions>
+parse_options(std::span<char const *const> args) {
+  if (args.size() < 4
+      || !std::ranges::all_of(std::string_view{args[1]}, is_digit)
+      || !std::ranges::all_of(std::string_view{args[2]}, is_digit)) {
+    return std::nullopt;
+  }
+  LoadOptions options{.m_socket_path = args[0],
+                      .m_request = {.m_day = str_to_int<u8>(args[1]),
+                                    .m_part = str_to_int<u8>(args[2]),
+                                    .m_inline = false,
+                                    .m_input = args[3]},
+                      .m_num_clients = 8,
+                      .m_num_requests = 1000};
+  for (std::size_t idx = 4; idx < args.size(); ++idx) {
+    std::string_view const option{args[idx]};
+    if (option == "--inline") {
+      options.m_request.m_inline = true;
+      continue;
+    }
+    if (idx + 1 == args.size()
+        || !std::ranges::all_of(std::string_view{args[idx + 1]}, is_digit)) {
+      return std::nullopt;
+    }
+    std::size_t const value = str_to_int<std::size_t>(args[++idx]);
+    if (option == "--clients" && value > 0) {
+      options.m_num_clients = value;
+    } else if (option == "--requests" && value > 0) {
+      options.m_num_requests = value;
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  if (options.m_request.m_inline
+      && !read_file(args[3], options.m_request.m_input)) {
+    return std::nullopt;
+  }
+  return options;
+}
+
+void
+print_latencies(std::vector<std::chrono::nanoseconds> &latencies,
+                std::chrono::nanoseconds elapsed) {
+  std::ranges::sort(latencies);
+  auto const to_us = [](std::chrono::nanoseconds duration) {
+    return static_cast<double>(duration.count()) / 1e3;
+  };
+  auto const percentile = [&](double fraction) {
+    auto const idx = static_cast<std::size_t>(
+        fraction * static_cast<double>(latencies.size() - 1));
+    return to_us(latencies[idx]);
+  };
+
+  std::println("requests: {} in {:.3f} s, {:.1f} requests/s",
+               latencies.size(),
+               to_us(elapsed) / 1e6,
+               static_cast<double>(latencies.size()) / (to_us(elapsed) / 1e6));
+  std::println("latency (us): p50 {:.1f} p90 {:.1f} p99 {:.1f} p99.9 {:.1f} "
+               "max {:.1f}",
+               percentile(0.5),
+               percentile(0.9),
+               percentile(0.99),
+               percentile(0.999),
+               to_us(latencies.back()));
+}
+} // namespace
@@ -0,0 +1,429 @@
+#include "memory_stats.hpp" // get_memory_stats
+#include "solver.hpp" // get_solvers
+#include "utility.hpp"
+
+#include <algorithm> // std::ranges::all_of, std::ranges::nth_element
+#include <array> // std::array
+#include <chrono> // std::chrono::steady_clock
+#include <cmath> // std::log
+#include <format> // std::format
+#include <limits> // std::numeric_limits
+#include <optional> // std::optional
+#include <print> // std::println
+#include <random> // std::mt19937_64
+#include <span> // std::span
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <vector> // std::vector
+
+namespace
+{
+struct ScalingOptions
+{
+  std::size_t m_base_size;
+  std::size_t m_num_steps;
+  std::chrono::milliseconds m_time_limit;
+  bool m_csv;
+  std::span<char const *const> m_selection;
+};
+
+struct Measurement
+{
+  std::size_t m_size;
+  /// the median of the timed solves
+  std::chrono::nanoseconds m_elapsed;
+  /// of the first solve, which is the only cold one: its peak RSS above the
+  /// RSS before it, and its page faults
+  u64 m_peak_rss_kib;
+  u64 m_minor_faults;
+  u64 m_major_faults;
+};
+
+/// the growth of the running time that the measurements fit best
+struct Fit
+{
+  Complexity m_complexity;
+  /// the least squares slope of log(time) against log(size)
+  double m_exponent;
+  /// the one-sided 95% lower confidence bound of that slope, from the scatter
+  /// of the measurements about the line: a step in the running time, e.g.
+  /// where the input outgrows a cache level, widens the interval instead of
+  /// passing for a steeper growth
+  double m_min_exponent;
+};
+
+/// the models fitted, from the slowest growing one
+constexpr std::array MODELS{Complexity::CONSTANT,
+                            Complexity::LOGARITHMIC,
+                            Complexity::LINEAR,
+                            Complexity::N_LOG_N,
+                            Complexity::QUADRATIC,
+                            Complexity::CUBIC};
+/// how much steeper than its budget the growth may be, for the noise
+constexpr double EXPONENT_TOLERANCE{0.25};
+/// every size is solved again until it was solved this many times and this
+/// much time was spent on it, and the median run is kept
+constexpr std::size_t MIN_RUNS{5};
+constexpr std::chrono::milliseconds MIN_MEASURE_TIME{20};
+/// Student's t at 95%, one-sided, for 1 to 10 degrees of freedom; the last
+/// one stands in for more, which only makes the bound a little wider
+constexpr std::array T_QUANTILES{
+    6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833, 1.812};
+
+std::optional<ScalingOptions>
+parse_options(std::span<char const *const> args);
+std::vector<Measurement>
+measure(Solver const &solver, ScalingOptions const &options);
+std::chrono::nanoseconds
+time_solve(Solver const &solver, std::vector<std::string> const &lines);
+std::optional<Fit>
+fit(std::vector<Measurement> const &measurements);
+bool
+is_within_budget(Complexity budget, Fit const &fit, std::size_t size);
+double
+evaluate(Complexity complexity, double size);
+double
+get_exponent(Complexity complexity, double size);
+std::string_view
+get_complexity_name(Complexity complexity);
+} // namespace
+
+/// Scaling curves of the solvers with an input generator: each one solves
+/// generated inputs of `base` times 1, 2, 4... up to 2^(steps-1) elements
+/// (fewer once a solve takes longer than `time-limit` ms), the running times
+/// are fitted to O(1), O(log n), O(n), O(n log n), O(n^2) and O(n^3), and the
+/// solvers whose running time grows faster than their declared budget, with
+/// 95% confidence, are flagged. A table of the fits is printed, with the
+/// memory use at the largest size, or with --csv every measurement along with
+/// its solver's fit.
+int
+main(int argc, char const **argv) {
+  auto args = std::span(argv, std::size_t(argc));
+  std::optional<ScalingOptions> const options = parse_options(args.subspan(1));
+  if (!options) {
+    std::println(stderr,
+                 "usage: {} [--base N] [--steps N] [--time-limit MS] [--csv] "
+                 "[day|dNNpM...]",
+                 args[0]);
+    return 1;
+  }
+  start_memory_watchdog();
+
+  if (options->m_csv) {
+    std::println("solver,size,ns,peak_rss_kib,minor_faults,major_faults,fit,"
+                 "exponent,min_exponent,budget,within_budget");
+  } else {
+    std::println("{:<8}{:>8}{:>10}{:>14}{:>10}{:>14}{:>10}{:>10}{:>14}  {}",
+                 "solver",
+                 "sizes",
+                 "max size",
+                 "peak rss KiB",
+                 "faults",
+                 "fit",
+                 "exponent",
+                 "at least",
+                 "budget",
+                 "verdict");
+  }
+  int ret_val = 0;
+  for (Solver const &solver : get_solvers()) {
+    if (!solver.m_generate || !is_selected(solver, options->m_selection)) {
+      continue;
+    }
+    solver.m_tests();
+    std::vector<Measurement> const measurements = measure(solver, *options);
+    std::optional<Fit> const best_fit = fit(measurements);
+    Measurement const &largest = measurements.back();
+    bool const within_budget =
+        !best_fit
+        || is_within_budget(solver.m_complexity, *best_fit, largest.m_size);
+    if (!within_budget) {
+      ret_val = 1;
+    }
+
+    std::string const fit_name{
+        best_fit ? get_complexity_name(best_fit->m_complexity) : "-"};
+    std::string const exponent =
+        best_fit ? std::format("{:.2f}", best_fit->m_exponent) : "-";
+    std::string const min_exponent =
+        best_fit ? std::format("{:.2f}", best_fit->m_min_exponent) : "-";
+    if (options->m_csv) {
+      for (Measurement const &measurement : measurements) {
+        std::println("{},{},{},{},{},{},{},{},{},{},{}",
+                     get_solver_name(solver),
+                     measurement.m_size,
+                     measurement.m_elapsed.count(),
+                     measurement.m_peak_rss_kib,
+                     measurement.m_minor_faults,
+                     measurement.m_major_faults,
+                     fit_name,
+                     exponent,
+                     min_exponent,
+                     get_complexity_name(solver.m_complexity),
+                     within_budget ? 1 : 0);
+      }
+      continue;
+    }
+    std::string_view verdict = within_budget ? "ok" : "OVER BUDGET";
+    if (!best_fit) {
+      verdict = "too few sizes";
+    } else if (solver.m_complexity == Complexity::UNKNOWN) {
+      verdict = "no budget";
+    }
+    std::println("{:<8}{:>8}{:>10}{:>14}{:>10}{:>14}{:>10}{:>10}{:>14}  {}",
+                 get_solver_name(solver),
+                 measurements.size(),
+                 largest.m_size,
+                 largest.m_peak_rss_kib,
+                 largest.m_minor_faults + largest.m_major_faults,
+                 fit_name,
+                 exponent,
+                 min_exponent,
+                 get_complexity_name(solver.m_complexity),
+                 verdict);
+  }
+  return ret_val;
+}
+
+namespace
+{
+std::optional<ScalingOptions>
+parse_options(std::span<char const *const> args) {
+  ScalingOptions options{.m_base_size = 16,
+                         .m_num_steps = 11,
+                         .m_time_limit = std::chrono::milliseconds{1000},
+                         .m_csv = false,
+                         .m_selection = {}};
+  std::size_t idx = 0;
+  for (; idx < args.size() && std::string_view(args[idx]).starts_with("--");
+       ++idx) {
+    std::string_view const option{args[idx]};
+    if (option == "--csv") {
+      options.m_csv = true;
+      continue;
+    }
+    if (idx + 1 == args.size()
+        || !std::ranges::all_of(std::string_view{args[idx + 1]}, is_digit)) {
+      return std::nullopt;
+    }
+    u64 const value = str_to_int<u64>(args[++idx]);
+    if (value == 0) {
+      return std::nullopt;
+    }
+    if (option == "--base") {
+      options.m_base_size = value;
+    } else if (option == "--steps" && value < 32) {
+      options.m_num_steps = value;
+    } else if (option == "--time-limit") {
+      options.m_time_limit = std::chrono::milliseconds{value};
+    } else {
+      return std::nullopt;
+    }
+  }
+  options.m_selection = args.subspan(idx);
+  return options;
+}
+
+std::vector<Measurement>
+measure(Solver const &solver, ScalingOptions const &options) {
+  std::vector<Measurement> measurements;
+  for (std::size_t step = 0; step < options.m_num_steps; ++step) {
+    std::size_t const size = options.m_base_size << step;
+    std::seed_seq seed_seq{static_cast<u32>(solver.m_day),
+                           static_cast<u32>(solver.m_part),
+                           static_cast<u32>(size)};
+    std::mt19937_64 rng(seed_seq);
+    std::vector<std::string> const lines = solver.m_generate(rng, size);
+
+    // the peak is the whole process's so far where it can't be reset
+    reset_peak_rss();
+    MemoryStats const before = get_memory_stats();
+    solver.m_solve(lines);
+    MemoryStats const after = get_memory_stats();
+    measurements.push_back(
+        {.m_size = size,
+         .m_elapsed = time_solve(solver, lines),
+         .m_peak_rss_kib =
+             after.m_peak_rss_kib - std::min(after.m_peak_rss_kib,
+                                             before.m_rss_kib),
+         .m_minor_faults = after.m_minor_faults - before.m_minor_faults,
+         .m_major_faults = after.m_major_faults - before.m_major_faults});
+    if (measurements.back().m_elapsed > options.m_time_limit) {
+      break;
+    }
+  }
+  return measurements;
+}
+
+std::chrono::nanoseconds
+time_solve(Solver const &solver, std::vector<std::string> const &lines) {
+  std::vector<std::chrono::nanoseconds> runs;
+  std::chrono::nanoseconds total{};
+  while (runs.size() < MIN_RUNS || total < MIN_MEASURE_TIME) {
+    auto const start = std::chrono::steady_clock::now();
+    solver.m_solve(lines);
+    runs.emplace_back(std::chrono::steady_clock::now() - start);
+    total += runs.back();
+  }
+  auto const median = runs.begin() + std::ptrdiff_t(runs.size() / 2);
+  std::ranges::nth_element(runs, median);
+  return *median;
+}
+
+/// the model with the least relative RMS error, each scaled by its least
+/// squares coefficient; nullopt with fewer than 3 sizes
+std::optional<Fit>
+fit(std::vector<Measurement> const &measurements) {
+  if (measurements.size() < 3) {
+    return std::nullopt;
+  }
+  double mean_time{};
+  for (Measurement const &measurement : measurements) {
+    mean_time += static_cast<double>(measurement.m_elapsed.count());
+  }
+  mean_time /= static_cast<double>(measurements.size());
+
+  Fit best{.m_complexity = Complexity::UNKNOWN,
+           .m_exponent = 0,
+           .m_min_exponent = 0};
+  double best_rms = std::numeric_limits<double>::max();
+  for (Complexity const complexity : MODELS) {
+    double sum_time_model{};
+    double sum_model_sq{};
+    for (Measurement const &measurement : measurements) {
+      double const model =
+          evaluate(complexity, static_cast<double>(measurement.m_size));
+      sum_time_model +=
+          static_cast<double>(measurement.m_elapsed.count()) * model;
+      sum_model_sq += model * model;
+    }
+    double const coefficient = sum_time_model / sum_model_sq;
+    double sum_error_sq{};
+    for (Measurement const &measurement : measurements) {
+      double const error =
+          static_cast<double>(measurement.m_elapsed.count())
+          - (coefficient
+             * evaluate(complexity, static_cast<double>(measurement.m_size)));
+      sum_error_sq += error * error;
+    }
+    double const rms =
+        std::sqrt(sum_error_sq / static_cast<double>(measurements.size()))
+        / mean_time;
+    if (rms < best_rms) {
+      best_rms = rms;
+      best.m_complexity = complexity;
+    }
+  }
+
+  // least squares slope in log-log space, and its standard error
+  double mean_x{};
+  double mean_y{};
+  for (Measurement const &measurement : measurements) {
+    mean_x += std::log(static_cast<double>(measurement.m_size));
+    mean_y += std::log(static_cast<double>(measurement.m_elapsed.count()));
+  }
+  mean_x /= static_cast<double>(measurements.size());
+  mean_y /= static_cast<double>(measurements.size());
+  double sum_xy{};
+  double sum_xx{};
+  for (Measurement const &measurement : measurements) {
+    double const x = std::log(static_cast<double>(measurement.m_size)) - mean_x;
+    double const y =
+        std::log(static_cast<double>(measurement.m_elapsed.count())) - mean_y;
+    sum_xy += x * y;
+    sum_xx += x * x;
+  }
+  best.m_exponent = sum_xy / sum_xx;
+  double sum_residual_sq{};
+  for (Measurement const &measurement : measurements) {
+    double const x = std::log(static_cast<double>(measurement.m_size)) - mean_x;
+    double const y =
+        std::log(static_cast<double>(measurement.m_elapsed.count())) - mean_y;
+    double const residual = y - (best.m_exponent * x);
+    sum_residual_sq += residual * residual;
+  }
+  std::size_t const degrees_of_freedom = measurements.size() - 2;
+  double const standard_error = std::sqrt(
+      sum_residual_sq / static_cast<double>(degrees_of_freedom) / sum_xx);
+  best.m_min_exponent =
+      best.m_exponent
+      - (T_QUANTILES[std::min(degrees_of_freedom, T_QUANTILES.size()) - 1]
+         * standard_error);
+  return best;
+}
+
+/// whether the exponent may be, as far as the measurements tell, at most the
+/// budget's own at the largest size, which is above 1 for O(n log n), plus
+/// some tolerance
+bool
+is_within_budget(Complexity budget, Fit const &fit, std::size_t size) {
+  if (budget == Complexity::UNKNOWN) {
+    return true;
+  }
+  return fit.m_min_exponent
+         <= get_exponent(budget, static_cast<double>(size))
+                + EXPONENT_TOLERANCE;
+}
+
+double
+evaluate(Complexity complexity, double size) {
+  switch (complexity) {
+  case Complexity::UNKNOWN:
+  case Complexity::CONSTANT:
+    return 1;
+  case Complexity::LOGARITHMIC:
+    return std::log2(size);
+  case Complexity::LINEAR:
+    return size;
+  case Complexity::N_LOG_N:
+    return size * std::log2(size);
+  case Complexity::QUADRATIC:
+    return size * size;
+  case Complexity::CUBIC:
+    return size * size * size;
+  }
+  UNREACHABLE();
+}
+
+/// the slope of the model in log-log space at `size`: d log f / d log n
+double
+get_exponent(Complexity complexity, double size) {
+  switch (complexity) {
+  case Complexity::UNKNOWN:
+  case Complexity::CONSTANT:
+    return 0;
+  case Complexity::LOGARITHMIC:
+    return 1 / std::log(size);
+  case Complexity::LINEAR:
+    return 1;
+  case Complexity::N_LOG_N:
+    return 1 + (1 / std::log(size));
+  case Complexity::QUADRATIC:
+    return 2;
+  case Complexity::CUBIC:
+    return 3;
+  }
+  UNREACHABLE();
+}
+
+std::string_view
+get_complexity_name(Complexity complexity) {
+  switch (complexity) {
+  case Complexity::UNKNOWN:
+    return "-";
+  case Complexity::CONSTANT:
+    return "O(1)";
+  case Complexity::LOGARITHMIC:
+    return "O(log n)";
+  case Complexity::LINEAR:
+    return "O(n)";
+  case Complexity::N_LOG_N:
+    return "O(n log n)";
+  case Complexity::QUADRATIC:
+    return "O(n^2)";
+  case Complexity::CUBIC:
+    return "O(n^3)";
+  }
+  UNREACHABLE();
+}
+} // namespace
@@ -0,0 +1,310 @@
+#include "memory_stats.hpp" // print_memory_stats
+#include "protocol.hpp" // Connection
+#include "result_cache.hpp" // cached_solve
+#include "solver.hpp" // find_solver
+#include "task_scheduler.hpp" // TaskGroup
+#include "utility.hpp"
+
+#include <algorithm> // std::ranges::all_of
+#include <atomic> // std::atomic
+#include <cerrno> // errno
+#include <chrono> // std::chrono::steady_clock
+#include <csignal> // sigwait
+#include <exception> // std::exception
+#include <format> // std::format
+#include <mutex> // std::mutex
+#include <optional> // std::optional
+#include <print> // std::println
+#include <semaphore> // std::counting_semaphore
+#include <span> // std::span
+#include <string> // std::string
+#include <sys/socket.h> // accept4
+#include <thread> // std::thread
+#include <unistd.h> // close
+#include <unordered_set> // std::unordered_set
+#include <vector> // std::vector
+
+namespace
+{
+/// the default limit of an inline payload, as anyone who can connect to the
+/// socket may send one
+constexpr std::size_t DEFAULT_MAX_INLINE_MB{16};
+
+struct ServerOptions
+{
+  std::string m_socket_path;
+  std::ptrdiff_t m_max_clients;
+  std::ptrdiff_t m_max_inflight;
+  std::size_t m_max_inline_size;
+};
+
+/// Serves solve requests until stop() is called. A pool of `max_clients`
+/// connection threads, each accepting a client and serving it until it goes
+/// away, does the socket I/O; the solves themselves run on the shared
+/// scheduler. Backpressure comes from two limits: while every connection
+/// thread is busy further clients wait in the listen backlog, and no more than
+/// `max_inflight` solves are queued at once. A solve that fails an assertion,
+/// as a malformed input makes it do, only fails its own request (see
+/// throw_on_solver_failures()).
+class Server
+{
+public:
+  Server(int listen_fd, ServerOptions const &options);
+
+  void
+  run();
+  void
+  stop();
+
+private:
+  int m_listen_fd;
+  std::ptrdiff_t m_max_clients;
+  std::size_t m_max_inline_size;
+  std::counting_semaphore<> m_inflight_slots;
+  std::atomic<bool> m_stop{false};
+  std::atomic<u64> m_num_requests{0};
+  std::mutex m_clients_mutex;
+  std::unordered_set<int> m_client_fds;
+
+  void
+  run_connection_thread();
+  void
+  serve(Connection connection);
+  Response
+  solve(Request const &request);
+};
+
+std::optional<ServerOptions>
+parse_options(std::span<char const *const> args);
+} // namespace
+
+/// The resident solver daemon: keeps every solver loaded and answers requests
+/// in the protocol.hpp format on a Unix socket until SIGINT or SIGTERM.
+int
+main(int argc, char const **argv) {
+  // block the termination signals before any thread, the scheduler's workers
+  // included, is started, so that only the signal thread below receives them
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  auto args = std::span(argv, std::size_t(argc));
+  std::optional<ServerOptions> const options = parse_options(args.subspan(1));
+  if (!options) {
+    std::println(stderr,
+                 "usage: {} socket_path [--max-clients N] [--max-inflight N] "
+                 "[--max-inline-mb N]",
+                 args[0]);
+    return 1;
+  }
+  start_memory_watchdog();
+
+  for (Solver const &solver : get_solvers()) {
+    solver.m_tests();
+  }
+  throw_on_solver_failures();
+
+  int const listen_fd = listen_unix(options->m_socket_path, SOMAXCONN);
+  if (listen_fd == -1) {
+    std::println(stderr, "couldn't listen on {}", options->m_socket_path);
+    return 1;
+  }
+  std::println(stderr,
+               "aocd: listening on {} with {} workers, {} clients and {} "
+               "solves in flight at most",
+               options->m_socket_path,
+               default_scheduler().num_workers(),
+               options->m_max_clients,
+               options->m_max_inflight);
+
+  Server server(listen_fd, *options);
+  std::thread([&server, signals] {
+    int signal{};
+    sigwait(&signals, &signal);
+    server.stop();
+  }).detach();
+  server.run();
+
+  close(listen_fd);
+  unlink(options->m_socket_path.c_str());
+  default_scheduler().print_stats(stderr);
+  if (ResultCache const *cache = default_result_cache()) {
+    cache->print_stats(stderr);
+  }
+  print_memory_stats(stderr);
+  return 0;
+}
+
+namespace
+{
+Server::Server(int listen_fd, ServerOptions const &options)
+    : m_listen_fd(listen_fd),
+      m_max_clients(options.m_max_clients),
+      m_max_inline_size(options.m_max_inline_size),
+      m_inflight_slots(options.m_max_inflight) {}
+
+void
+Server::run() {
+  std::vector<std::thread> connection_threads;
+  connection_threads.reserve(std::size_t(m_max_clients));
+  for (std::ptrdiff_t idx = 0; idx < m_max_clients; ++idx) {
+    connection_threads.emplace_back([this] { run_connection_thread(); });
+  }
+  // until stop(), whose shutdown also hurries the connected clients away
+  for (std::thread &thread : connection_threads) {
+    thread.join();
+  }
+  std::println(stderr, "aocd: served {} requests", m_num_requests.load());
+}
+
+void
+Server::stop() {
+  m_stop.store(true);
+  shutdown(m_listen_fd, SHUT_RDWR);
+  std::lock_guard const lock(m_clients_mutex);
+  for (int const fd : m_client_fds) {
+    shutdown(fd, SHUT_RDWR);
+  }
+}
+
+void
+Server::run_connection_thread() {
+  while (!m_stop.load()) {
+    int const fd = accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd == -1) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      break;
+    }
+    {
+      std::lock_guard const lock(m_clients_mutex);
+      // stop() may have come between the accept and here
+      if (m_stop.load()) {
+        close(fd);
+        break;
+      }
+      m_client_fds.insert(fd);
+    }
+    serve(Connection(fd));
+  }
+}
+
+void
+Server::serve(Connection connection) {
+  Request request{};
+  std::string error;
+  while (!m_stop.load()
+         && connection.receive_request(request, error, m_max_inline_size)) {
+    if (!error.empty()) {
+      connection.send_response(
+          {.m_ok = false, .m_answer = error, .m_time_us = 0});
+      break;
+    }
+    if (!connection.send_response(solve(request))) {
+      break;
+    }
+    m_num_requests.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::lock_guard const lock(m_clients_mutex);
+  m_client_fds.erase(connection.fd());
+}
+
+Response
+Server::solve(Request const &request) {
+  Solver const *solver = find_solver(request.m_day, request.m_part);
+  if (solver == nullptr) {
+    return {.m_ok = false,
+            .m_answer = std::format("no solver for day {} part {}",
+                                    request.m_day,
+                                    request.m_part),
+            .m_time_us = 0};
+  }
+
+  m_inflight_slots.acquire();
+  std::optional<std::string> answer;
+  std::chrono::steady_clock::duration elapsed{};
+  std::string failure;
+  try {
+    TaskGroup group(default_scheduler());
+    group.spawn([&] {
+      // a path is read by the solve, which may go through the model cache
+      auto const start = std::chrono::steady_clock::now();
+      if (!request.m_inline) {
+        answer = cached_solve_file(*solver, request.m_input.c_str());
+      } else if (std::vector<std::string> const lines =
+                     split_lines(request.m_input);
+                 !lines.empty()) {
+        answer = cached_solve(*solver, lines);
+      }
+      elapsed = std::chrono::steady_clock::now() - start;
+    });
+    group.wait();
+  } catch (std::exception const &exception) {
+    failure = exception.what();
+  }
+  m_inflight_slots.release();
+
+  if (!failure.empty()) {
+    std::println(stderr,
+                 "aocd: the solve of day {} part {} failed: {}",
+                 request.m_day,
+                 request.m_part,
+                 failure);
+    return {.m_ok = false,
+            .m_answer = std::format("the solve of day {} part {} failed",
+                                    request.m_day,
+                                    request.m_part),
+            .m_time_us = 0};
+  }
+  if (!answer) {
+    return {.m_ok = false,
+            .m_answer = std::format("couldn't read input {}",
+                                    request.m_inline ? "payload"
+                                                     : request.m_input),
+            .m_time_us = 0};
+  }
+  return {.m_ok = true,
+          .m_answer = *std::move(answer),
+          .m_time_us = static_cast<u64>(
+              std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                  .count())};
+}
+
+std::optional<ServerOptions>
+parse_options(std::span<char const *const> args) {
+  if (args.empty()) {
+    return std::nullopt;
+  }
+  auto const num_workers =
+      static_cast<std::ptrdiff_t>(default_scheduler().num_workers());
+  ServerOptions options{.m_socket_path = args[0],
+                        .m_max_clients = 256,
+                        .m_max_inflight = 2 * num_workers,
+                        .m_max_inline_size = DEFAULT_MAX_INLINE_MB << 20U};
+  for (std::size_t idx = 1; idx + 1 < args.size(); idx += 2) {
+    std::string_view const option{args[idx]};
+    std::string_view const value{args[idx + 1]};
+    if (!std::ranges::all_of(value, is_digit) || value.empty()) {
+      return std::nullopt;
+    }
+    if (option == "--max-clients") {
+      options.m_max_clients = str_to_int<std::ptrdiff_t>(value);
+    } else if (option == "--max-inflight") {
+      options.m_max_inflight = str_to_int<std::ptrdiff_t>(value);
+    } else if (option == "--max-inline-mb") {
+      options.m_max_inline_size = str_to_int<std::size_t>(value) << 20U;
+    } else {
+      return std::nullopt;
+    }
+  }
+  if (args.size() % 2 == 0 || options.m_max_clients <= 0
+      || options.m_max_inflight <= 0) {
+    return std::nullopt;
+  }
+  return options;
+}
+} // namespace
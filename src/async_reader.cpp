@@ -0,0 +1,554 @@
+#include "async_reader.hpp"
+#include "decompression.hpp" // decompress
+
+#include <algorithm> // std::min
+#include <bit> // std::bit_width
+#include <cerrno> // errno
+#include <chrono> // std::chrono::steady_clock
+#include <cstdlib> // std::getenv
+#include <cstring> // std::memset
+#include <format> // std::format
+#include <fcntl.h> // open
+#include <linux/io_uring.h> // io_uring_params
+#include <print> // std::println
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#include <sys/syscall.h> // __NR_io_uring_setup
+#include <sys/uio.h> // iovec
+#include <unistd.h> // pread
+
+namespace
+{
+/// the most a single read asks for; a larger file takes several
+constexpr u64 MAX_READ_SIZE{u64{1} << 30};
+
+/// call `on_read` with the file's contents, decompressed if they're compressed
+void
+deliver(AsyncReader::OnRead const &on_read,
+        std::size_t idx,
+        std::optional<std::string_view> contents);
+std::size_t
+get_bucket(u64 value);
+void
+print_histogram(std::FILE *stream,
+                std::string_view name,
+                AsyncReader::Histogram const &histogram);
+} // namespace
+
+/// A read in flight, or the file handed to a task, in one queue slot.
+struct AsyncReader::Slot
+{
+  /// this slot's registered buffer
+  char *m_buffer;
+  /// the file, when it doesn't fit in m_buffer
+  std::string m_large;
+  int m_fd{-1};
+  std::size_t m_path_idx{};
+  u64 m_size{};
+  u64 m_num_read{};
+  std::chrono::steady_clock::time_point m_submitted;
+
+  explicit Slot(char *buffer) : m_buffer(buffer) {}
+
+  [[nodiscard]] char *
+  data() {
+    return m_large.empty() ? m_buffer : m_large.data();
+  }
+
+  bool
+  open_file(std::filesystem::path const &path,
+            std::size_t path_idx,
+            std::size_t buffer_size) {
+    m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd == -1) {
+      return false;
+    }
+    struct stat file_stat{};
+    if (fstat(m_fd, &file_stat) == -1) {
+      close_file();
+      return false;
+    }
+    m_path_idx = path_idx;
+    m_size = static_cast<u64>(file_stat.st_size);
+    m_num_read = 0;
+    if (m_size > buffer_size) {
+      m_large.resize(m_size);
+    }
+    m_submitted = std::chrono::steady_clock::now();
+    return true;
+  }
+
+  void
+  close_file() {
+    close(m_fd);
+    m_fd = -1;
+  }
+};
+
+/// An io_uring instance, set up with raw system calls: a submission queue of
+/// reads and a completion queue, both shared with the kernel. Only the reading
+/// thread touches them.
+struct AsyncReader::Ring
+{
+  int m_fd{-1};
+  void *m_sq_ring{nullptr};
+  std::size_t m_sq_ring_size{};
+  void *m_cq_ring{nullptr};
+  std::size_t m_cq_ring_size{};
+  io_uring_sqe *m_sqes{nullptr};
+  std::size_t m_sqes_size{};
+
+  u32 *m_sq_tail{};
+  u32 m_sq_mask{};
+  u32 *m_sq_array{};
+  u32 *m_cq_head{};
+  u32 *m_cq_tail{};
+  u32 m_cq_mask{};
+  io_uring_cqe *m_cqes{};
+
+  u32 m_num_unsubmitted{};
+  bool m_fixed_buffers{false};
+
+  Ring() = default;
+  Ring(Ring const &) = delete;
+  Ring(Ring &&) = delete;
+  Ring &
+  operator=(Ring const &) = delete;
+  Ring &
+  operator=(Ring &&) = delete;
+  ~Ring() {
+    if (m_sqes != nullptr) {
+      munmap(m_sqes, m_sqes_size);
+    }
+    if (m_cq_ring != nullptr && m_cq_ring != m_sq_ring) {
+      munmap(m_cq_ring, m_cq_ring_size);
+    }
+    if (m_sq_ring != nullptr) {
+      munmap(m_sq_ring, m_sq_ring_size);
+    }
+    if (m_fd != -1) {
+      close(m_fd);
+    }
+  }
+
+  /// nullptr when the kernel doesn't let us set up a ring
+  static std::unique_ptr<Ring>
+  create(u32 num_entries, std::span<iovec const> buffers) {
+    io_uring_params params{};
+    auto ring = std::make_unique<Ring>();
+    ring->m_fd =
+        static_cast<int>(syscall(__NR_io_uring_setup, num_entries, &params));
+    if (ring->m_fd < 0) {
+      ring->m_fd = -1;
+      return nullptr;
+    }
+
+    ring->m_sq_ring_size =
+        params.sq_off.array + (params.sq_entries * sizeof(u32));
+    ring->m_cq_ring_size =
+        params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe));
+    bool const single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      ring->m_sq_ring_size = ring->m_cq_ring_size =
+          std::max(ring->m_sq_ring_size, ring->m_cq_ring_size);
+    }
+    ring->m_sq_ring = map(ring->m_fd, ring->m_sq_ring_size, IORING_OFF_SQ_RING);
+    if (ring->m_sq_ring == nullptr) {
+      return nullptr;
+    }
+    ring->m_cq_ring =
+        single_mmap
+            ? ring->m_sq_ring
+            : map(ring->m_fd, ring->m_cq_ring_size, IORING_OFF_CQ_RING);
+    ring->m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    ring->m_sqes = static_cast<io_uring_sqe *>(
+        map(ring->m_fd, ring->m_sqes_size, IORING_OFF_SQES));
+    if (ring->m_cq_ring == nullptr || ring->m_sqes == nullptr) {
+      return nullptr;
+    }
+
+    auto *sq_ring = static_cast<char *>(ring->m_sq_ring);
+    auto *cq_ring = static_cast<char *>(ring->m_cq_ring);
+    ring->m_sq_tail = reinterpret_cast<u32 *>(sq_ring + params.sq_off.tail);
+    ring->m_sq_mask =
+        *reinterpret_cast<u32 *>(sq_ring + params.sq_off.ring_mask);
+    ring->m_sq_array = reinterpret_cast<u32 *>(sq_ring + params.sq_off.array);
+    ring->m_cq_head = reinterpret_cast<u32 *>(cq_ring + params.cq_off.head);
+    ring->m_cq_tail = reinterpret_cast<u32 *>(cq_ring + params.cq_off.tail);
+    ring->m_cq_mask =
+        *reinterpret_cast<u32 *>(cq_ring + params.cq_off.ring_mask);
+    ring->m_cqes =
+        reinterpret_cast<io_uring_cqe *>(cq_ring + params.cq_off.cqes);
+
+    // pinned once, instead of on every read; plain reads still work without
+    ring->m_fixed_buffers = syscall(__NR_io_uring_register,
+                                    ring->m_fd,
+                                    IORING_REGISTER_BUFFERS,
+                                    buffers.data(),
+                                    static_cast<unsigned>(buffers.size()))
+                            == 0;
+    return ring;
+  }
+
+  /// queue a read of the rest of the slot's file
+  void
+  prepare_read(Slot &slot, std::size_t slot_idx) {
+    u32 const tail = *m_sq_tail;
+    u32 const sqe_idx = tail & m_sq_mask;
+    io_uring_sqe &sqe = m_sqes[sqe_idx];
+    std::memset(&sqe, 0, sizeof(sqe));
+    bool const is_fixed = m_fixed_buffers && slot.m_large.empty();
+    sqe.opcode = is_fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe.fd = slot.m_fd;
+    sqe.off = slot.m_num_read;
+    sqe.addr = reinterpret_cast<u64>(slot.data() + slot.m_num_read);
+    sqe.len = static_cast<u32>(
+        std::min(slot.m_size - slot.m_num_read, MAX_READ_SIZE));
+    sqe.buf_index = is_fixed ? static_cast<std::uint16_t>(slot_idx) : 0;
+    sqe.user_data = slot_idx;
+    m_sq_array[sqe_idx] = sqe_idx;
+    // the kernel may pick the entry up as soon as it sees the new tail
+    std::atomic_ref(*m_sq_tail).store(tail + 1, std::memory_order_release);
+    ++m_num_unsubmitted;
+  }
+
+  /// submit the queued reads and wait for at least one completion
+  void
+  submit_and_wait() {
+    for (;;) {
+      long const num_submitted = syscall(__NR_io_uring_enter,
+                                         m_fd,
+                                         m_num_unsubmitted,
+                                         1,
+                                         IORING_ENTER_GETEVENTS,
+                                         nullptr,
+                                         0);
+      if (num_submitted >= 0) {
+        m_num_unsubmitted -= static_cast<u32>(num_submitted);
+        return;
+      }
+      ASSERT(errno == EINTR);
+    }
+  }
+
+  /// call `on_completion(slot_idx, result)` for every completed read
+  template <typename F>
+  void
+  reap(F &&on_completion) {
+    u32 head = *m_cq_head;
+    u32 const tail =
+        std::atomic_ref(*m_cq_tail).load(std::memory_order_acquire);
+    for (; head != tail; ++head) {
+      io_uring_cqe const &cqe = m_cqes[head & m_cq_mask];
+      on_completion(static_cast<std::size_t>(cqe.user_data), cqe.res);
+    }
+    // frees the entries for the kernel to reuse
+    std::atomic_ref(*m_cq_head).store(head, std::memory_order_release);
+  }
+
+private:
+  static void *
+  map(int fd, std::size_t size, off_t offset) {
+    void *data = mmap(nullptr,
+                      size,
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE,
+                      fd,
+                      offset);
+    return data == MAP_FAILED ? nullptr : data;
+  }
+};
+
+AsyncReader::AsyncReader(TaskScheduler &scheduler,
+                         std::size_t queue_depth,
+                         std::size_t buffer_size)
+    : m_scheduler(scheduler), m_buffer_size(buffer_size),
+      m_buffers(std::make_unique_for_overwrite<char[]>(queue_depth
+                                                       * buffer_size)) {
+  ASSERT(queue_depth > 0);
+  std::vector<iovec> buffers;
+  for (std::size_t idx = 0; idx < queue_depth; ++idx) {
+    char *buffer = m_buffers.get() + (idx * buffer_size);
+    m_slots.emplace_back(buffer);
+    buffers.emplace_back(iovec{.iov_base = buffer, .iov_len = buffer_size});
+    // popped from the back: the first slots go first
+    m_free_slots.emplace_back(queue_depth - 1 - idx);
+  }
+  char const *backend = std::getenv("AOC_READER");
+  if (backend == nullptr || std::string_view(backend) != "pread") {
+    m_ring = Ring::create(static_cast<u32>(queue_depth), buffers);
+  }
+}
+
+AsyncReader::~AsyncReader() = default;
+
+void
+AsyncReader::read_all(std::span<std::filesystem::path const> paths,
+                      OnRead const &on_read) {
+  if (m_ring) {
+    read_all_io_uring(paths, on_read);
+  } else {
+    read_all_pread(paths, on_read);
+  }
+}
+
+AsyncReader::Backend
+AsyncReader::backend() const {
+  return m_ring ? Backend::IO_URING : Backend::PREAD;
+}
+
+AsyncReader::Stats
+AsyncReader::get_stats() const {
+  Stats stats{.m_backend = backend(),
+              .m_num_files = m_num_files.load(),
+              .m_num_failed = m_num_failed.load(),
+              .m_num_bytes = m_num_bytes.load(),
+              .m_queue_depth = {},
+              .m_latency_us = {}};
+  for (std::size_t idx = 0; idx < NUM_BUCKETS; ++idx) {
+    stats.m_queue_depth[idx] = m_queue_depth[idx].load();
+    stats.m_latency_us[idx] = m_latency_us[idx].load();
+  }
+  return stats;
+}
+
+void
+AsyncReader::print_stats(std::FILE *stream) const {
+  Stats const stats = get_stats();
+  std::println(stream,
+               "reader: {}, {} slots, {} files, {} failed, {:.1f} MiB",
+               stats.m_backend == Backend::IO_URING
+                   ? (m_ring->m_fixed_buffers ? "io_uring (registered buffers)"
+                                              : "io_uring")
+                   : "pread",
+               m_slots.size(),
+               stats.m_num_files,
+               stats.m_num_failed,
+               static_cast<double>(stats.m_num_bytes) / (1024.0 * 1024.0));
+  print_histogram(stream, "queue depth", stats.m_queue_depth);
+  print_histogram(stream, "latency (us)", stats.m_latency_us);
+}
+
+std::optional<std::size_t>
+AsyncReader::acquire_slot() {
+  std::lock_guard const lock(m_free_mutex);
+  if (m_free_slots.empty()) {
+    return std::nullopt;
+  }
+  std::size_t const slot_idx = m_free_slots.back();
+  m_free_slots.pop_back();
+  return slot_idx;
+}
+
+void
+AsyncReader::release_slot(std::size_t slot_idx) {
+  // a large file's buffer isn't kept around for the next one
+  std::string().swap(m_slots[slot_idx].m_large);
+  std::lock_guard const lock(m_free_mutex);
+  m_free_slots.emplace_back(slot_idx);
+}
+
+std::size_t
+AsyncReader::wait_for_slot() {
+  std::optional<std::size_t> slot_idx;
+  m_scheduler.run_until([&] {
+    slot_idx = acquire_slot();
+    return slot_idx.has_value();
+  });
+  return *slot_idx;
+}
+
+void
+AsyncReader::read_all_io_uring(std::span<std::filesystem::path const> paths,
+                               OnRead const &on_read) {
+  TaskGroup group(m_scheduler);
+  auto hand_off = [&](std::size_t slot_idx, bool ok) {
+    group.spawn([this, &on_read, slot_idx, ok] {
+      Slot &slot = m_slots[slot_idx];
+      std::optional<std::string_view> contents;
+      if (ok) {
+        contents.emplace(slot.data(), slot.m_num_read);
+      }
+      try {
+        deliver(on_read, slot.m_path_idx, contents);
+      } catch (...) {
+        release_slot(slot_idx);
+        throw;
+      }
+      release_slot(slot_idx);
+    });
+  };
+
+  u64 num_in_flight{};
+  std::size_t next_path_idx{};
+  while (next_path_idx < paths.size() || num_in_flight > 0) {
+    // every free slot gets a read; with none in flight, the only way forward
+    // is a task releasing its slot
+    for (; next_path_idx < paths.size(); ++next_path_idx) {
+      std::optional<std::size_t> const slot_idx =
+          num_in_flight == 0 ? wait_for_slot() : acquire_slot();
+      if (!slot_idx) {
+        break;
+      }
+      Slot &slot = m_slots[*slot_idx];
+      if (!slot.open_file(paths[next_path_idx], next_path_idx, m_buffer_size)) {
+        slot.m_path_idx = next_path_idx;
+        m_num_files.fetch_add(1, std::memory_order_relaxed);
+        m_num_failed.fetch_add(1, std::memory_order_relaxed);
+        hand_off(*slot_idx, false);
+        continue;
+      }
+      if (slot.m_size == 0) {
+        slot.close_file();
+        record_completion(slot, true);
+        hand_off(*slot_idx, true);
+        continue;
+      }
+      m_ring->prepare_read(slot, *slot_idx);
+      record_submission(++num_in_flight);
+    }
+    if (num_in_flight == 0) {
+      continue;
+    }
+
+    m_ring->submit_and_wait();
+    m_ring->reap([&](std::size_t slot_idx, int result) {
+      Slot &slot = m_slots[slot_idx];
+      if (result > 0) {
+        slot.m_num_read += static_cast<u64>(result);
+        if (slot.m_num_read < slot.m_size) {
+          // a short read: ask for the rest
+          m_ring->prepare_read(slot, slot_idx);
+          return;
+        }
+      }
+      // a read of 0 bytes means the file shrank since its fstat()
+      --num_in_flight;
+      slot.close_file();
+      record_completion(slot, result >= 0);
+      hand_off(slot_idx, result >= 0);
+    });
+  }
+  group.wait();
+}
+
+void
+AsyncReader::read_all_pread(std::span<std::filesystem::path const> paths,
+                            OnRead const &on_read) {
+  TaskGroup group(m_scheduler);
+  for (std::size_t path_idx = 0; path_idx < paths.size(); ++path_idx) {
+    std::size_t const slot_idx = wait_for_slot();
+    group.spawn([this, &on_read, &path = paths[path_idx], path_idx, slot_idx] {
+      Slot &slot = m_slots[slot_idx];
+      bool ok = slot.open_file(path, path_idx, m_buffer_size);
+      if (ok) {
+        record_submission(m_num_in_flight.fetch_add(1) + 1);
+        while (slot.m_num_read < slot.m_size) {
+          ssize_t const num_read =
+              pread(slot.m_fd,
+                    slot.data() + slot.m_num_read,
+                    std::min(slot.m_size - slot.m_num_read, MAX_READ_SIZE),
+                    static_cast<off_t>(slot.m_num_read));
+          if (num_read == -1 && errno == EINTR) {
+            continue;
+          }
+          if (num_read <= 0) {
+            ok = num_read == 0;
+            break;
+          }
+          slot.m_num_read += static_cast<u64>(num_read);
+        }
+        m_num_in_flight.fetch_sub(1);
+        slot.close_file();
+        record_completion(slot, ok);
+      } else {
+        m_num_files.fetch_add(1, std::memory_order_relaxed);
+        m_num_failed.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      std::optional<std::string_view> contents;
+      if (ok) {
+        contents.emplace(slot.data(), slot.m_num_read);
+      }
+      try {
+        deliver(on_read, path_idx, contents);
+      } catch (...) {
+        release_slot(slot_idx);
+        throw;
+      }
+      release_slot(slot_idx);
+    });
+  }
+  group.wait();
+}
+
+void
+AsyncReader::record_submission(u64 num_in_flight) {
+  m_queue_depth[get_bucket(num_in_flight)].fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void
+AsyncReader::record_completion(Slot const &slot, bool ok) {
+  auto const latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - slot.m_submitted);
+  m_latency_us[get_bucket(static_cast<u64>(latency.count()))].fetch_add(
+      1, std::memory_order_relaxed);
+  m_num_files.fetch_add(1, std::memory_order_relaxed);
+  if (ok) {
+    m_num_bytes.fetch_add(slot.m_num_read, std::memory_order_relaxed);
+  } else {
+    m_num_failed.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+namespace
+{
+void
+deliver(AsyncReader::OnRead const &on_read,
+        std::size_t idx,
+        std::optional<std::string_view> contents) {
+  Compression const compression =
+      contents ? detect_compression(*contents) : Compression::NONE;
+  if (compression == Compression::NONE) {
+    on_read(idx, contents);
+    return;
+  }
+  std::string decompressed;
+  if (!decompress(*contents, compression, decompressed)) {
+    on_read(idx, std::nullopt);
+    return;
+  }
+  on_read(idx, decompressed);
+}
+
+std::size_t
+get_bucket(u64 value) {
+  return std::min<std::size_t>(std::bit_width(value),
+                               AsyncReader::NUM_BUCKETS - 1);
+}
+
+void
+print_histogram(std::FILE *stream,
+                std::string_view name,
+                AsyncReader::Histogram const &histogram) {
+  u64 total{};
+  for (u64 const count : histogram) {
+    total += count;
+  }
+  std::println(stream, "  {}:", name);
+  for (std::size_t idx = 0; idx < histogram.size(); ++idx) {
+    if (histogram[idx] == 0) {
+      continue;
+    }
+    u64 const low = idx == 0 ? 0 : u64{1} << (idx - 1);
+    u64 const high = idx == 0 ? 1 : u64{1} << idx;
+    std::println(stream,
+                 "  {:>24} {:>10} {:>6.1f}%",
+                 std::format("[{}, {})", low, high),
+                 histogram[idx],
+                 100.0 * static_cast<double>(histogram[idx])
+                     / static_cast<double>(total));
+  }
+}
+} // namespace
@@ -0,0 +1,126 @@
+#ifndef ASYNC_READER_HPP
+#define ASYNC_READER_HPP
+
+#include "task_scheduler.hpp" // TaskScheduler
+#include "utility.hpp" // u64
+
+#include <array> // std::array
+#include <atomic> // std::atomic
+#include <cstdio> // std::FILE
+#include <filesystem> // std::filesystem::path
+#include <functional> // std::function
+#include <memory> // std::unique_ptr
+#include <mutex> // std::mutex
+#include <optional> // std::optional
+#include <span> // std::span
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <vector> // std::vector
+
+/// Reads many whole files with many reads in flight at once, and hands each
+/// file, as soon as it's read, to a task on the scheduler. Reads go through
+/// io_uring into buffers registered with the kernel once, so that the calling
+/// thread only submits reads and reaps their completions while the workers
+/// solve; where io_uring isn't available, or with AOC_READER=pread, each read
+/// is a blocking pread() on a worker instead. Either way there is one buffer
+/// per queue slot, and a slot is only reused once the task given its buffer
+/// returns, which bounds the memory to the queue depth times the buffer size.
+/// A file larger than a buffer is read into a buffer of its own.
+class AsyncReader
+{
+public:
+  enum class Backend : std::uint8_t
+  {
+    IO_URING,
+    PREAD
+  };
+
+  /// power of two buckets: bucket 0 counts 0, bucket i counts [2^(i-1), 2^i)
+  static constexpr std::size_t NUM_BUCKETS{24};
+  using Histogram = std::array<u64, NUM_BUCKETS>;
+
+  struct Stats
+  {
+    Backend m_backend;
+    u64 m_num_files;
+    u64 m_num_failed;
+    u64 m_num_bytes;
+    /// the number of reads in flight, sampled at every submission
+    Histogram m_queue_depth;
+    /// from the submission of a file's read to its completion, in us
+    Histogram m_latency_us;
+  };
+
+  /// called once per file, from a scheduler task, with the file's contents;
+  /// nullopt when it can't be read. The contents are only valid during the
+  /// call.
+  using OnRead =
+      std::function<void(std::size_t idx, std::optional<std::string_view>)>;
+
+  AsyncReader(TaskScheduler &scheduler,
+              std::size_t queue_depth = DEFAULT_QUEUE_DEPTH,
+              std::size_t buffer_size = DEFAULT_BUFFER_SIZE);
+  AsyncReader(AsyncReader const &) = delete;
+  AsyncReader(AsyncReader &&) = delete;
+  AsyncReader &
+  operator=(AsyncReader const &) = delete;
+  AsyncReader &
+  operator=(AsyncReader &&) = delete;
+  ~AsyncReader();
+
+  /// read every file of `paths`, calling `on_read` with its index in `paths`;
+  /// returns once every call has returned
+  void
+  read_all(std::span<std::filesystem::path const> paths, OnRead const &on_read);
+
+  [[nodiscard]] Backend
+  backend() const;
+  [[nodiscard]] Stats
+  get_stats() const;
+  void
+  print_stats(std::FILE *stream) const;
+
+private:
+  static constexpr std::size_t DEFAULT_QUEUE_DEPTH{64};
+  static constexpr std::size_t DEFAULT_BUFFER_SIZE{64 * 1024};
+
+  struct Ring;
+  struct Slot;
+  using AtomicHistogram = std::array<std::atomic<u64>, NUM_BUCKETS>;
+
+  TaskScheduler &m_scheduler;
+  std::size_t m_buffer_size;
+  std::unique_ptr<char[]> m_buffers;
+  std::vector<Slot> m_slots;
+  std::mutex m_free_mutex;
+  std::vector<std::size_t> m_free_slots;
+  /// null with the pread backend
+  std::unique_ptr<Ring> m_ring;
+
+  std::atomic<u64> m_num_in_flight{0};
+  std::atomic<u64> m_num_files{0};
+  std::atomic<u64> m_num_failed{0};
+  std::atomic<u64> m_num_bytes{0};
+  AtomicHistogram m_queue_depth{};
+  AtomicHistogram m_latency_us{};
+
+  std::optional<std::size_t>
+  acquire_slot();
+  void
+  release_slot(std::size_t slot_idx);
+  /// block, running scheduler tasks, until a slot is released
+  std::size_t
+  wait_for_slot();
+  void
+  read_all_io_uring(std::span<std::filesystem::path const> paths,
+                    OnRead const &on_read);
+  void
+  read_all_pread(std::span<std::filesystem::path const> paths,
+                 OnRead const &on_read);
+  void
+  record_submission(u64 num_in_flight);
+  void
+  record_completion(Slot const &slot, bool ok);
+};
+
+#endif // ASYNC_READER_HPP
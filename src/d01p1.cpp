@@ -1,46 +1,106 @@
 #include <algorithm> // std::ranges::find_if
-#include <print> // std::println
+#include <array> // std::array
+#include <bit> // std::countr_zero
+#include <cstring> // std::memcpy
+#include <format> // std::format
+#include <random> // std::mt19937_64
 #include <ranges> // std::ranges::reverse_view
 #include <string> // std::string
 
+#ifdef __x86_64__
+#include <immintrin.h> // _mm256_movemask_epi8
+#endif
+
+#include "decompression.hpp" // detect_file_compression
+#include "model_cache.hpp" // map_file
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
 namespace
 {
 void
 tests();
-std::uint64_t
+constexpr std::uint64_t
 get_sum_of_calibration_values(std::ranges::range auto &&lines);
+/// the sum over a whole input held in memory, scanned as it is rather than
+/// split into lines: with AVX2 where the CPU has it, byte by byte otherwise
+std::uint64_t
+get_sum_of_calibration_values_in_buffer(std::string_view buffer);
+std::uint64_t
+get_sum_of_calibration_values_in_buffer_scalar(std::string_view buffer);
+#ifdef __x86_64__
+std::uint64_t
+get_sum_of_calibration_values_in_buffer_avx2(std::string_view buffer);
+#endif
+std::string
+solve(std::vector<std::string> const &lines);
+std::optional<std::string>
+solve_file(char const *path);
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-
-  std::vector<std::string> const lines = read_program_input(argc, argv);
-  if (lines.empty()) {
-    return 1;
-  }
-
-  std::println("{}", get_sum_of_calibration_values(lines));
-  return 0;
+  return solver_main(argc, argv, 1, 1);
 }
+#endif
 
 namespace
 {
+SolverRegistrar const registrar{
+    {.m_day = 1,
+     .m_part = 1,
+     .m_tests = tests,
+     .m_solve = solve,
+     .m_solve_file = solve_file,
+     .m_make_accumulator =
+         [] {
+           return make_line_sum_accumulator([](std::string_view line) {
+             return get_sum_of_calibration_values(std::array{line});
+           });
+         },
+     .m_reference =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}", get_sum_of_calibration_values(lines));
+         },
+     .m_generate = generate_input,
+     .m_complexity = Complexity::LINEAR}};
+} // namespace
+
+namespace
+{
+constexpr std::array<std::string_view, 4> EXAMPLE{
+    "1abc2",
+    "pqr3stu8vwx",
+    "a1b2c3d4e5f",
+    "treb7uchet",
+};
+
 void
 tests() {
-  using namespace std::literals::string_view_literals;
-  auto const lines = std::array{
-      "1abc2"sv,
-      "pqr3stu8vwx"sv,
-      "a1b2c3d4e5f"sv,
-      "treb7uchet"sv,
-  };
-  ASSERT(get_sum_of_calibration_values(lines) == 142);
+  ASSERT(get_sum_of_calibration_values(EXAMPLE) == 142);
+
+  // lines across and within the blocks of the AVX2 kernel, and a last line
+  // without its newline
+  std::string buffer;
+  std::uint64_t expected{};
+  for (std::size_t idx = 0; idx < 50; ++idx) {
+    for (std::string_view const line : EXAMPLE) {
+      buffer += std::string(idx, 'x');
+      buffer += line;
+      buffer += '\n';
+    }
+    expected += 142;
+  }
+  buffer.pop_back();
+  ASSERT(get_sum_of_calibration_values_in_buffer(buffer) == expected);
+  ASSERT(get_sum_of_calibration_values_in_buffer_scalar(buffer) == expected);
+  ASSERT(solve(split_lines(buffer)) == std::format("{}", expected));
 }
 
-std::uint64_t
+constexpr std::uint64_t
 get_sum_of_calibration_values(std::ranges::range auto &&lines) {
   std::uint64_t total{};
   for (auto const &line : lines) {
@@ -52,4 +112,178 @@ get_sum_of_calibration_values(std::ranges::range auto &&lines) {
   }
   return total;
 }
+
+std::uint64_t
+get_sum_of_calibration_values_in_buffer(std::string_view buffer) {
+#ifdef __x86_64__
+  static bool const has_avx2 = __builtin_cpu_supports("avx2") != 0
+                               && __builtin_cpu_supports("bmi") != 0
+                               && __builtin_cpu_supports("lzcnt") != 0;
+  if (has_avx2) {
+    return get_sum_of_calibration_values_in_buffer_avx2(buffer);
+  }
+#endif
+  return get_sum_of_calibration_values_in_buffer_scalar(buffer);
+}
+
+std::uint64_t
+get_sum_of_calibration_values_in_buffer_scalar(std::string_view buffer) {
+  std::uint64_t total{};
+  // the first and the last digit of the current line; '\0' before its first
+  char first{};
+  char last{};
+  for (char const ch : buffer) {
+    if (is_digit(ch)) {
+      if (first == '\0') {
+        first = ch;
+      }
+      last = ch;
+    } else if (ch == '\n') {
+      if (first != '\0') {
+        total += char_to_int(first) * 10UL + char_to_int(last);
+      }
+      first = '\0';
+    }
+  }
+  if (first != '\0') {
+    total += char_to_int(first) * 10UL + char_to_int(last);
+  }
+  return total;
+}
+
+#ifdef __x86_64__
+/// 64 bytes at a time, as a mask of their digits and one of their newlines: a
+/// line's first and last digits in the block are the lowest and the highest
+/// bits of the digits before its newline, so the work per block is a few
+/// instructions per line in it rather than per byte
+__attribute__((target("avx2,bmi,lzcnt"))) std::uint64_t
+get_sum_of_calibration_values_in_buffer_avx2(std::string_view buffer) {
+  constexpr std::size_t BLOCK_SIZE{64};
+  __m256i const below_zero = _mm256_set1_epi8('0' - 1);
+  __m256i const above_nine = _mm256_set1_epi8('9' + 1);
+  __m256i const newline = _mm256_set1_epi8('\n');
+
+  // the last, partial block, padded with bytes that are neither
+  std::size_t const num_full_blocks = buffer.size() / BLOCK_SIZE;
+  std::array<char, BLOCK_SIZE> last_block{};
+  std::memcpy(last_block.data(),
+              buffer.data() + (num_full_blocks * BLOCK_SIZE),
+              buffer.size() % BLOCK_SIZE);
+
+  std::uint64_t total{};
+  char first{};
+  char last{};
+  for (std::size_t block_idx = 0; block_idx <= num_full_blocks; ++block_idx) {
+    char const *block = block_idx < num_full_blocks
+                            ? buffer.data() + (block_idx * BLOCK_SIZE)
+                            : last_block.data();
+    std::uint64_t digits{};
+    std::uint64_t newlines{};
+    for (std::size_t half = 0; half < 2; ++half) {
+      __m256i const bytes = _mm256_loadu_si256(
+          reinterpret_cast<__m256i const *>(block + (half * 32)));
+      // signed compares, which the bytes above 0x7f fail as negative
+      __m256i const is_digit_byte =
+          _mm256_and_si256(_mm256_cmpgt_epi8(bytes, below_zero),
+                           _mm256_cmpgt_epi8(above_nine, bytes));
+      digits |= std::uint64_t{static_cast<std::uint32_t>(
+                    _mm256_movemask_epi8(is_digit_byte))}
+                << (half * 32);
+      newlines |= std::uint64_t{static_cast<std::uint32_t>(
+                      _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)))}
+                  << (half * 32);
+    }
+
+    while (true) {
+      // the digits of the current line in this block
+      std::uint64_t const before_newline =
+          newlines == 0 ? ~std::uint64_t{0}
+                        : (std::uint64_t{1} << std::countr_zero(newlines)) - 1;
+      if (std::uint64_t const line_digits = digits & before_newline;
+          line_digits != 0) {
+        if (first == '\0') {
+          first = block[std::countr_zero(line_digits)];
+        }
+        last = block[63 - std::countl_zero(line_digits)];
+      }
+      if (newlines == 0) {
+        break;
+      }
+      if (first != '\0') {
+        total += char_to_int(first) * 10UL + char_to_int(last);
+      }
+      first = '\0';
+      digits &= ~before_newline;
+      newlines &= newlines - 1;
+    }
+  }
+  if (first != '\0') {
+    total += char_to_int(first) * 10UL + char_to_int(last);
+  }
+  return total;
+}
+#endif
+
+/// the kernel over each line in place: a line is a buffer of its own, whose
+/// last block the kernel handles as it does the partial block at the end of a
+/// file
+std::string
+solve(std::vector<std::string> const &lines) {
+  std::uint64_t total{};
+  for (std::string const &line : lines) {
+    total += get_sum_of_calibration_values_in_buffer(line);
+  }
+  return std::format("{}", total);
+}
+
+/// the whole file in one buffer, mapped rather than read where it isn't
+/// compressed
+std::optional<std::string>
+solve_file(char const *path) {
+  if (detect_file_compression(path) == Compression::NONE) {
+    if (std::optional<MappedFile> const file = map_file(path)) {
+      return std::format("{}",
+                         get_sum_of_calibration_values_in_buffer(file->data()));
+    }
+  }
+  std::string contents;
+  if (!read_file(path, contents) || contents.empty()) {
+    return std::nullopt;
+  }
+  return std::format("{}", get_sum_of_calibration_values_in_buffer(contents));
+}
+
+/// `size` lines of letters and digits, at least one, of up to 200 bytes, so
+/// that lines both share and straddle the blocks of the AVX2 kernel
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size) {
+  std::uniform_int_distribution<std::size_t> length(1, 200);
+  std::uniform_int_distribution<int> byte(0, 35);
+  std::vector<std::string> lines;
+  for (std::size_t idx = 0; idx < size; ++idx) {
+    std::string line(length(rng), 'a');
+    for (char &ch : line) {
+      int const value = byte(rng);
+      ch = static_cast<char>(value < 10 ? '0' + value : 'a' + value - 10);
+    }
+    line[std::uniform_int_distribution<std::size_t>(0, line.size() - 1)(rng)] =
+        static_cast<char>('0' + byte(rng) % 10);
+    lines.emplace_back(std::move(line));
+  }
+  return lines;
+}
+
+static_assert(get_sum_of_calibration_values(EXAMPLE) == 142);
 } // namespace
+
+#ifdef AOC_EMBED_INPUT
+#include AOC_EMBED_INPUT // EMBEDDED_INPUT
+
+int
+main(int argc, char const **argv) {
+  static constexpr std::uint64_t ANSWER =
+      get_sum_of_calibration_values(split_lines(EMBEDDED_INPUT));
+  return embedded_main(
+      argc, argv, 1, 1, std::format("{}", ANSWER), EMBEDDED_INPUT);
+}
+#endif
@@ -1,50 +1,244 @@
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
-#include <print> // std::println
+#include <algorithm> // std::ranges::reverse
+#include <array> // std::array
+#include <format> // std::format
+#include <random> // std::mt19937_64
 #include <ranges> // std::views::enumerate
 #include <string> // std::string
 
 namespace
 {
+/// An Aho-Corasick automaton over the spelled-out digits, unrolled into a DFA:
+/// a single transition per byte, and every state knows the digit whose word
+/// ends there, if any. The digit characters themselves need no states, as
+/// they match on their own.
+struct DigitDfa
+{
+  /// a state per letter of the words, and the start state 0
+  static constexpr std::size_t MAX_STATES{42};
+  /// the letters of the words; any other byte is class 0
+  static constexpr std::string_view LETTERS{"efghinorstuvwxz"};
+  static constexpr u8 NO_DIGIT{0xff};
+
+  [[nodiscard]] constexpr u8
+  get_next_state(u8 state, char ch) const;
+
+  /// the class of every byte, so that a transition is two lookups
+  std::array<u8, 256> m_class{};
+  std::array<std::array<u8, LETTERS.size() + 1>, MAX_STATES> m_next{};
+  std::array<u8, MAX_STATES> m_digit{};
+};
+
 void
 tests();
-std::uint64_t
+constexpr std::uint64_t
 get_sum_of_calibration_values(std::ranges::range auto &&lines);
-std::pair<bool, uint8_t>
+constexpr u8
+get_first_digit(std::string_view line);
+constexpr u8
+get_last_digit(std::string_view line);
+/// `reversed` for the words spelled backwards, to scan from the end of a line
+constexpr DigitDfa
+make_digit_dfa(bool reversed);
+constexpr u8
+get_letter_class(char ch);
+constexpr std::uint64_t
+get_sum_of_calibration_values_by_prefixes(std::ranges::range auto &&lines);
+constexpr std::pair<bool, uint8_t>
 str_to_digit(std::string_view sv);
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  if (lines.empty()) {
-    return 1;
-  }
-
-  std::println("{}", get_sum_of_calibration_values(lines));
-  return 0;
+  return solver_main(argc, argv, 1, 2);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 1,
+     .m_part = 2,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}", get_sum_of_calibration_values(lines));
+         },
+     .m_make_accumulator =
+         [] {
+           return make_line_sum_accumulator([](std::string_view line) {
+             return get_sum_of_calibration_values(std::array{line});
+           });
+         },
+     .m_reference =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}",
+                              get_sum_of_calibration_values_by_prefixes(lines));
+         },
+     .m_generate = generate_input,
+     .m_complexity = Complexity::LINEAR}};
+} // namespace
 
 namespace
 {
+constexpr std::array<std::string_view, 7> EXAMPLE{
+    "two1nine",
+    "eightwothree",
+    "abcone2threexyz",
+    "xtwone3four",
+    "4nineeightseven2",
+    "zoneight234",
+    "7pqrstsixteen",
+};
+
+constexpr auto NUMBERS = std::array<std::pair<char, char const *>, 10>{{
+    {'0', "zero"},
+    {'1', "one"},
+    {'2', "two"},
+    {'3', "three"},
+    {'4', "four"},
+    {'5', "five"},
+    {'6', "six"},
+    {'7', "seven"},
+    {'8', "eight"},
+    {'9', "nine"},
+}};
+
 void
 tests() {
-  using namespace std::literals::string_view_literals;
-  auto const lines = std::array{
-      "two1nine"sv,
-      "eightwothree"sv,
-      "abcone2threexyz"sv,
-      "xtwone3four"sv,
-      "4nineeightseven2"sv,
-      "zoneight234"sv,
-      "7pqrstsixteen"sv,
-  };
-  ASSERT(get_sum_of_calibration_values(lines) == 281);
+  ASSERT(get_sum_of_calibration_values(EXAMPLE) == 281);
+  ASSERT(get_sum_of_calibration_values_by_prefixes(EXAMPLE) == 281);
+  // overlapping words, and words whose prefix is another's suffix
+  ASSERT(get_first_digit("eightwo") == 8);
+  ASSERT(get_last_digit("eightwo") == 2);
+  ASSERT(get_first_digit("sevenine") == 7);
+  ASSERT(get_last_digit("sevenine") == 9);
+  ASSERT(get_first_digit("ththree") == 3);
+  ASSERT(get_last_digit("fivfive") == 5);
+  ASSERT(get_first_digit("nineight") == 9);
+  ASSERT(get_last_digit("zerone") == 1);
 }
 
-std::uint64_t
+constexpr std::uint64_t
 get_sum_of_calibration_values(std::ranges::range auto &&lines) {
+  std::uint64_t total{};
+  for (auto const &line : lines) {
+    if (u8 const first = get_first_digit(line); first != DigitDfa::NO_DIGIT) {
+      total += 10UL * first + get_last_digit(line);
+    }
+  }
+  return total;
+}
+
+constexpr DigitDfa
+make_digit_dfa(bool reversed) {
+  DigitDfa dfa;
+  for (std::size_t byte = 0; byte < dfa.m_class.size(); ++byte) {
+    dfa.m_class[byte] = get_letter_class(static_cast<char>(byte));
+  }
+  dfa.m_digit.fill(DigitDfa::NO_DIGIT);
+
+  // the trie of the words, in m_next, where 0 stands for no child as the
+  // start state is nobody's child
+  u8 num_states{1};
+  for (auto const &[digit, number] : std::views::enumerate(NUMBERS)) {
+    std::string word(number.second);
+    if (reversed) {
+      std::ranges::reverse(word);
+    }
+    u8 state{0};
+    for (char const ch : word) {
+      u8 &next = dfa.m_next[state][get_letter_class(ch)];
+      if (next == 0) {
+        next = num_states++;
+      }
+      state = next;
+    }
+    dfa.m_digit[state] = static_cast<u8>(digit);
+  }
+
+  // then breadth first, so that the state a failed match falls back to (the
+  // longest proper suffix of the state's word that is in the trie) is already
+  // complete: a missing child becomes the fallback state's transition, and a
+  // state inherits the digit of its fallback state, whose word ends there too
+  std::array<u8, DigitDfa::MAX_STATES> fallback{};
+  std::array<u8, DigitDfa::MAX_STATES> queue{};
+  std::size_t queue_begin{0};
+  std::size_t queue_end{0};
+  for (u8 const child : dfa.m_next[0]) {
+    if (child != 0) {
+      queue[queue_end++] = child;
+    }
+  }
+  while (queue_begin != queue_end) {
+    u8 const state = queue[queue_begin++];
+    for (std::size_t letter = 0; letter < dfa.m_next[state].size(); ++letter) {
+      u8 const fallback_next = dfa.m_next[fallback[state]][letter];
+      u8 &next = dfa.m_next[state][letter];
+      if (next == 0) {
+        next = fallback_next;
+        continue;
+      }
+      fallback[next] = fallback_next;
+      if (dfa.m_digit[next] == DigitDfa::NO_DIGIT) {
+        dfa.m_digit[next] = dfa.m_digit[fallback_next];
+      }
+      queue[queue_end++] = next;
+    }
+  }
+  return dfa;
+}
+
+constexpr u8
+get_letter_class(char ch) {
+  std::size_t const idx = DigitDfa::LETTERS.find(ch);
+  return idx == std::string_view::npos ? 0 : static_cast<u8>(idx + 1);
+}
+
+constexpr u8
+DigitDfa::get_next_state(u8 state, char ch) const {
+  return m_next[state][m_class[static_cast<u8>(ch)]];
+}
+
+constexpr DigitDfa FORWARD_DFA = make_digit_dfa(false);
+constexpr DigitDfa BACKWARD_DFA = make_digit_dfa(true);
+
+constexpr u8
+get_first_digit(std::string_view line) {
+  u8 state{0};
+  for (char const ch : line) {
+    if (is_digit(ch)) {
+      return char_to_int(ch);
+    }
+    state = FORWARD_DFA.get_next_state(state, ch);
+    if (FORWARD_DFA.m_digit[state] != DigitDfa::NO_DIGIT) {
+      return FORWARD_DFA.m_digit[state];
+    }
+  }
+  return DigitDfa::NO_DIGIT;
+}
+
+constexpr u8
+get_last_digit(std::string_view line) {
+  u8 state{0};
+  for (char const ch : std::views::reverse(line)) {
+    if (is_digit(ch)) {
+      return char_to_int(ch);
+    }
+    state = BACKWARD_DFA.get_next_state(state, ch);
+    if (BACKWARD_DFA.m_digit[state] != DigitDfa::NO_DIGIT) {
+      return BACKWARD_DFA.m_digit[state];
+    }
+  }
+  return DigitDfa::NO_DIGIT;
+}
+
+constexpr std::uint64_t
+get_sum_of_calibration_values_by_prefixes(std::ranges::range auto &&lines) {
   std::uint64_t total{};
   for (auto const &line : lines) {
     auto const line_len = line.size();
@@ -68,21 +262,8 @@ get_sum_of_calibration_values(std::ranges::range auto &&lines) {
   return total;
 }
 
-std::pair<bool, uint8_t>
+constexpr std::pair<bool, uint8_t>
 str_to_digit(std::string_view sv) {
-  static constexpr auto NUMBERS = std::array<std::pair<char, char const *>, 10>{{
-      {'0', "zero"},
-      {'1', "one"},
-      {'2', "two"},
-      {'3', "three"},
-      {'4', "four"},
-      {'5', "five"},
-      {'6', "six"},
-      {'7', "seven"},
-      {'8', "eight"},
-      {'9', "nine"},
-  }};
-
   for (auto const &[idx, digit_number] : std::views::enumerate(NUMBERS)) {
     if (sv.starts_with(digit_number.first)
         || sv.starts_with(digit_number.second)) {
@@ -91,4 +272,46 @@ str_to_digit(std::string_view sv) {
   }
   return {false, 0};
 }
+
+/// `size` lines mostly of the letters of the words, so that words often
+/// overlap, with a digit or a word somewhere in every one
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size) {
+  std::uniform_int_distribution<std::size_t> length(1, 40);
+  std::uniform_int_distribution<std::size_t> letter(
+      0, DigitDfa::LETTERS.size() - 1);
+  std::uniform_int_distribution<std::size_t> number(0, NUMBERS.size() - 1);
+  std::bernoulli_distribution is_word(0.1);
+  std::vector<std::string> lines;
+  for (std::size_t idx = 0; idx < size; ++idx) {
+    std::string line;
+    std::size_t const line_len = length(rng);
+    while (line.size() < line_len) {
+      if (is_word(rng)) {
+        line += NUMBERS[number(rng)].second;
+      } else {
+        line += DigitDfa::LETTERS[letter(rng)];
+      }
+    }
+    line.insert(std::uniform_int_distribution<std::size_t>(0, line.size())(rng),
+                1,
+                NUMBERS[number(rng)].first);
+    lines.emplace_back(std::move(line));
+  }
+  return lines;
+}
+
+static_assert(get_sum_of_calibration_values(EXAMPLE) == 281);
 } // namespace
+
+#ifdef AOC_EMBED_INPUT
+#include AOC_EMBED_INPUT // EMBEDDED_INPUT
+
+int
+main(int argc, char const **argv) {
+  static constexpr std::uint64_t ANSWER =
+      get_sum_of_calibration_values(split_lines(EMBEDDED_INPUT));
+  return embedded_main(
+      argc, argv, 1, 2, std::format("{}", ANSWER), EMBEDDED_INPUT);
+}
+#endif
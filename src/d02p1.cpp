@@ -1,10 +1,23 @@
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
-#include <algorithm> // std::ranges::all_of
+#include <algorithm> // std::ranges::transform
+#include <array> // std::array
+#include <charconv> // std::from_chars
+#include <chrono> // std::chrono::steady_clock
+#include <format> // std::format
+#include <numeric> // std::iota
+#include <optional> // std::optional
 #include <print> // std::println
+#include <random> // std::mt19937_64
+#include <ranges> // std::views::enumerate
+#include <span> // std::span
 #include <string> // std::string
+#include <system_error> // std::errc
 #include <vector> //std::vector
 
+namespace
+{
 struct GameSet
 {
   std::size_t m_red;
@@ -15,85 +28,237 @@ struct GameSet
 struct Game
 {
   std::size_t m_id;
-  std::vector<GameSet> m_sets;
+  /// the fewest cubes of each color the game could have been played with
+  GameSet m_min_game_set;
 };
 
-namespace
+/// the games of a log reduced once to their minimum game sets, as a structure
+/// of arrays, for answering many bags against the same games
+struct GameIndex
+{
+  std::vector<std::size_t> m_ids;
+  std::vector<std::size_t> m_reds;
+  std::vector<std::size_t> m_greens;
+  std::vector<std::size_t> m_blues;
+};
+
+/// A 2D Fenwick tree of sums, over dense (row, col) ranks from 1.
+class FenwickTree2d
 {
+public:
+  FenwickTree2d(std::size_t num_rows, std::size_t num_cols);
+
+  void
+  add(std::size_t row, std::size_t col, std::uint64_t value);
+  /// the sum over the ranks up to `row` and `col`, included
+  [[nodiscard]] std::uint64_t
+  get_prefix_sum(std::size_t row, std::size_t col) const;
+
+private:
+  std::size_t m_num_rows;
+  std::size_t m_num_cols;
+  std::vector<std::uint64_t> m_sums;
+};
+
 void
 tests();
-std::uint64_t
-get_sum_of_ids_of_possible_games(std::ranges::range auto &&lines);
-Game
+constexpr std::uint64_t
+get_sum_of_ids_of_possible_games(std::ranges::range auto &&lines,
+                                 auto parse_line);
+constexpr Game
 parse_game(std::string_view line);
-std::size_t
-parse_game_id(std::string_view game_id_line);
-std::vector<GameSet>
+constexpr Game
+parse_game_by_splitting(std::string_view line);
+constexpr std::vector<GameSet>
 parse_game_sets(std::string_view game_sets_line);
-GameSet
+constexpr GameSet
 parse_game_set(std::string_view game_set_line);
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size);
+GameIndex
+index_games(std::vector<std::string> const &lines);
+/// for every bag, the sum of the ids of the games possible with it
+std::vector<std::uint64_t>
+get_sums_of_ids_of_possible_games(GameIndex const &index,
+                                  std::span<GameSet const> bags);
+#ifndef AOC_NO_MAIN
+int
+run_queries(char const *bags_path, char const *path);
+/// a "red green blue" line of bags.txt; nullopt unless it's three whole
+/// numbers
+std::optional<GameSet>
+parse_bag(std::string_view line);
+#endif
 } // namespace
 
+#ifndef AOC_NO_MAIN
+/// Besides the modes of every dNNpM (see solver_main),
+///   d02p1 --queries bags.txt input.txt
+/// prints, for every "red green blue" line of bags.txt, the sum of the ids of
+/// the games of input.txt that are possible with that bag.
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_sum_of_ids_of_possible_games(lines));
-  return 0;
+  auto args = std::span(argv, std::size_t(argc));
+  if (args.size() == 4 && std::string_view(args[1]) == "--queries") {
+    return run_queries(args[2], args[3]);
+  }
+  return solver_main(argc, argv, 2, 1);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 2,
+     .m_part = 1,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format(
+               "{}", get_sum_of_ids_of_possible_games(lines, parse_game));
+         },
+     .m_make_accumulator =
+         [] {
+           return make_line_sum_accumulator([](std::string_view line) {
+             return get_sum_of_ids_of_possible_games(std::array{line},
+                                                     parse_game);
+           });
+         },
+     .m_reference =
+         [](std::vector<std::string> const &lines) {
+           return std::format(
+               "{}",
+               get_sum_of_ids_of_possible_games(lines,
+                                                parse_game_by_splitting));
+         },
+     .m_generate = generate_input,
+     .m_complexity = Complexity::LINEAR}};
+} // namespace
 
 namespace
 {
+constexpr std::array<std::string_view, 5> EXAMPLE{
+    "Game 1: 3 blue, 4 red; 1 red, 2 green, 6 blue; 2 green",
+    "Game 2: 1 blue, 2 green; 3 green, 4 blue, 1 red; 1 green, 1 blue",
+    "Game 3: 8 green, 6 blue, 20 red; 5 blue, 4 red, 13 green; 5 green, 1 red",
+    "Game 4: 1 green, 3 red, 6 blue; 3 green, 6 red; 3 green, 15 blue, 14 red",
+    "Game 5: 6 red, 1 blue, 3 green; 2 blue, 1 red, 2 green",
+};
+
 void
 tests() {
-  using namespace std::literals::string_view_literals;
-  auto const lines = std::array{
-      "Game 1: 3 blue, 4 red; 1 red, 2 green, 6 blue; 2 green"sv,
-      "Game 2: 1 blue, 2 green; 3 green, 4 blue, 1 red; 1 green, 1 blue"sv,
-      "Game 3: 8 green, 6 blue, 20 red; 5 blue, 4 red, 13 green; 5 green, 1 red"sv,
-      "Game 4: 1 green, 3 red, 6 blue; 3 green, 6 red; 3 green, 15 blue, 14 red"sv,
-      "Game 5: 6 red, 1 blue, 3 green; 2 blue, 1 red, 2 green"sv,
-  };
-  ASSERT(get_sum_of_ids_of_possible_games(lines) == 8);
+  ASSERT(get_sum_of_ids_of_possible_games(EXAMPLE, parse_game) == 8);
+  ASSERT(get_sum_of_ids_of_possible_games(EXAMPLE, parse_game_by_splitting)
+         == 8);
+
+  // every bag up to a few cubes past the example's, against checking every
+  // game against every bag
+  std::vector<std::string> const lines(EXAMPLE.begin(), EXAMPLE.end());
+  GameIndex const index = index_games(lines);
+  std::vector<GameSet> bags;
+  for (std::size_t red = 0; red <= 22; red += 2) {
+    for (std::size_t green = 0; green <= 15; ++green) {
+      for (std::size_t blue = 0; blue <= 17; blue += 3) {
+        bags.push_back({.m_red = red, .m_green = green, .m_blue = blue});
+      }
+    }
+  }
+  std::vector<std::uint64_t> const sums =
+      get_sums_of_ids_of_possible_games(index, bags);
+  for (std::size_t bag_idx = 0; bag_idx < bags.size(); ++bag_idx) {
+    std::uint64_t expected{};
+    for (std::size_t idx = 0; idx < index.m_ids.size(); ++idx) {
+      if (index.m_reds[idx] <= bags[bag_idx].m_red
+          && index.m_greens[idx] <= bags[bag_idx].m_green
+          && index.m_blues[idx] <= bags[bag_idx].m_blue) {
+        expected += index.m_ids[idx];
+      }
+    }
+    ASSERT(sums[bag_idx] == expected);
+  }
+  GameSet const bag{.m_red = 12, .m_green = 13, .m_blue = 14};
+  ASSERT(get_sums_of_ids_of_possible_games(index, std::array{bag})[0] == 8);
 }
 
-std::uint64_t
-get_sum_of_ids_of_possible_games(std::ranges::range auto &&lines) {
-  static constexpr std::size_t MAX_RED = 12;
-  static constexpr std::size_t MAX_GREEN = 13;
-  static constexpr std::size_t MAX_BLUE = 14;
+constexpr std::uint64_t
+get_sum_of_ids_of_possible_games(std::ranges::range auto &&lines,
+                                 auto parse_line) {
+  constexpr std::size_t MAX_RED = 12;
+  constexpr std::size_t MAX_GREEN = 13;
+  constexpr std::size_t MAX_BLUE = 14;
 
   std::uint64_t total{};
   for (auto const &line : lines) {
-    auto game = parse_game(line);
-    if (std::ranges::all_of(game.m_sets, [](GameSet const &game_set) {
-          return game_set.m_red <= MAX_RED && game_set.m_green <= MAX_GREEN
-                 && game_set.m_blue <= MAX_BLUE;
-        })) {
+    Game const game = parse_line(line);
+    if (game.m_min_game_set.m_red <= MAX_RED
+        && game.m_min_game_set.m_green <= MAX_GREEN
+        && game.m_min_game_set.m_blue <= MAX_BLUE) {
       total += game.m_id;
     }
   }
   return total;
 }
 
-Game
+/// A single pass over the line's bytes, folding every count into the running
+/// maximum of its color. The line is assumed to be well formed, as
+/// "Game <id>: <count> <color>, ...; ...", with every color one of "red",
+/// "green" and "blue": a color is then told by its first letter and skipped
+/// by its length, and the separators are skipped as they come.
+constexpr Game
 parse_game(std::string_view line) {
-  auto tokens = split(line, ": ");
-  return Game{.m_id = parse_game_id(tokens[0]),
-              .m_sets = parse_game_sets(tokens[1])};
+  constexpr std::size_t GAME_LEN{5 /*Game */};
+  Game game{.m_id = 0,
+            .m_min_game_set = {.m_red = 0, .m_green = 0, .m_blue = 0}};
+  std::size_t idx = GAME_LEN;
+  for (; idx < line.size() && is_digit(line[idx]); ++idx) {
+    game.m_id = (game.m_id * 10) + char_to_int(line[idx]);
+  }
+
+  std::size_t count{};
+  for (; idx < line.size(); ++idx) {
+    char const ch = line[idx];
+    if (is_digit(ch)) {
+      count = (count * 10) + char_to_int(ch);
+      continue;
+    }
+    GameSet &min_game_set = game.m_min_game_set;
+    switch (ch) {
+    case 'r':
+      min_game_set.m_red = std::max(min_game_set.m_red, count);
+      idx += 2 /*ed*/;
+      break;
+    case 'g':
+      min_game_set.m_green = std::max(min_game_set.m_green, count);
+      idx += 4 /*reen*/;
+      break;
+    case 'b':
+      min_game_set.m_blue = std::max(min_game_set.m_blue, count);
+      idx += 3 /*lue*/;
+      break;
+    default:
+      continue;
+    }
+    count = 0;
+  }
+  return game;
 }
 
-std::size_t
-parse_game_id(std::string_view game_id_line) {
-  static constexpr std::size_t GAME_LEN{5 /*Game */};
-  std::size_t game_id{};
-  std::from_chars(game_id_line.data() + GAME_LEN,
-                  game_id_line.data() + GAME_LEN + game_id_line.size(),
-                  game_id);
-  return game_id;
+constexpr Game
+parse_game_by_splitting(std::string_view line) {
+  constexpr std::size_t GAME_LEN{5 /*Game */};
+  auto tokens = split(line, ": ");
+  Game game{.m_id = str_to_int<std::size_t>(tokens[0].substr(GAME_LEN)),
+            .m_min_game_set = {.m_red = 0, .m_green = 0, .m_blue = 0}};
+  for (GameSet const &game_set : parse_game_sets(tokens[1])) {
+    GameSet &min_game_set = game.m_min_game_set;
+    min_game_set.m_red = std::max(min_game_set.m_red, game_set.m_red);
+    min_game_set.m_green = std::max(min_game_set.m_green, game_set.m_green);
+    min_game_set.m_blue = std::max(min_game_set.m_blue, game_set.m_blue);
+  }
+  return game;
 }
 
-std::vector<GameSet>
+constexpr std::vector<GameSet>
 parse_game_sets(std::string_view game_sets_line) {
   std::vector<GameSet> game_sets;
   auto tokens = split(game_sets_line, "; ");
@@ -101,13 +266,12 @@ parse_game_sets(std::string_view game_sets_line) {
   return game_sets;
 }
 
-GameSet
+constexpr GameSet
 parse_game_set(std::string_view game_set_line) {
   GameSet game_set{.m_red = 0, .m_green = 0, .m_blue = 0};
   for (std::string_view pair : split(game_set_line, ", ")) {
     auto tokens = split(pair);
-    std::size_t num{};
-    std::from_chars(tokens[0].data(), tokens[0].data() + tokens[0].size(), num);
+    auto const num = str_to_int<std::size_t>(tokens[0]);
     if (tokens[1] == "red") {
       game_set.m_red = num;
     } else if (tokens[1] == "green") {
@@ -119,4 +283,215 @@ parse_game_set(std::string_view game_set_line) {
   return game_set;
 }
 
+/// `size` games of up to 6 sets of up to 20 cubes of each color, the colors
+/// in any order
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size) {
+  static constexpr std::array<std::string_view, 3> COLORS{
+      "red", "green", "blue"};
+  std::uniform_int_distribution<std::size_t> num_sets(1, 6);
+  std::uniform_int_distribution<std::size_t> count(1, 20);
+  std::bernoulli_distribution is_shown(0.7);
+  std::vector<std::string> lines;
+  for (std::size_t idx = 0; idx < size; ++idx) {
+    std::string line = std::format("Game {}:", idx + 1);
+    for (std::size_t set_idx = num_sets(rng); set_idx > 0; --set_idx) {
+      std::array colors = COLORS;
+      std::ranges::shuffle(colors, rng);
+      std::string_view separator = " ";
+      for (std::string_view const color : colors) {
+        // every set shows at least one color
+        if (is_shown(rng) || (separator == " " && color == colors.back())) {
+          line += std::format("{}{} {}", separator, count(rng), color);
+          separator = ", ";
+        }
+      }
+      line += ';';
+    }
+    line.pop_back();
+    lines.emplace_back(std::move(line));
+  }
+  return lines;
+}
+
+GameIndex
+index_games(std::vector<std::string> const &lines) {
+  GameIndex index;
+  for (std::string const &line : lines) {
+    Game const game = parse_game(line);
+    index.m_ids.emplace_back(game.m_id);
+    index.m_reds.emplace_back(game.m_min_game_set.m_red);
+    index.m_greens.emplace_back(game.m_min_game_set.m_green);
+    index.m_blues.emplace_back(game.m_min_game_set.m_blue);
+  }
+  return index;
+}
+
+/// An offline sweep over red: the bags and the games are both taken in order
+/// of red, so that when a bag comes up, exactly the games with no more red
+/// than it have been added to a 2D Fenwick tree over the ranks of green and
+/// blue, and the bag's answer is one prefix sum of it. That's
+/// O((games + bags) log(games)^2) rather than O(games * bags), in memory
+/// quadratic in the distinct counts of green and blue, which are few as
+/// they're counts of cubes.
+std::vector<std::uint64_t>
+get_sums_of_ids_of_possible_games(GameIndex const &index,
+                                  std::span<GameSet const> bags) {
+  std::size_t const num_games = index.m_ids.size();
+  std::vector<std::size_t> game_order(num_games);
+  std::iota(game_order.begin(), game_order.end(), 0);
+  std::ranges::sort(game_order, {}, [&index](std::size_t idx) {
+    return index.m_reds[idx];
+  });
+  std::vector<std::size_t> bag_order(bags.size());
+  std::iota(bag_order.begin(), bag_order.end(), 0);
+  std::ranges::sort(bag_order, {}, [&bags](std::size_t idx) {
+    return bags[idx].m_red;
+  });
+
+  auto get_distinct = [](std::vector<std::size_t> values) {
+    std::ranges::sort(values);
+    auto const [first_duplicate, last_duplicate] = std::ranges::unique(values);
+    values.erase(first_duplicate, last_duplicate);
+    return values;
+  };
+  std::vector<std::size_t> const greens = get_distinct(index.m_greens);
+  std::vector<std::size_t> const blues = get_distinct(index.m_blues);
+  // the number of distinct values up to `value`, i.e. its rank from 1 when
+  // it's one of them
+  auto get_rank = [](std::vector<std::size_t> const &values,
+                     std::size_t value) {
+    return static_cast<std::size_t>(std::ranges::upper_bound(values, value)
+                                    - values.begin());
+  };
+
+  FenwickTree2d tree(greens.size(), blues.size());
+  std::vector<std::uint64_t> sums(bags.size());
+  std::size_t num_added{0};
+  for (std::size_t const bag_idx : bag_order) {
+    GameSet const &bag = bags[bag_idx];
+    for (; num_added < num_games
+           && index.m_reds[game_order[num_added]] <= bag.m_red;
+         ++num_added) {
+      std::size_t const game_idx = game_order[num_added];
+      tree.add(get_rank(greens, index.m_greens[game_idx]),
+               get_rank(blues, index.m_blues[game_idx]),
+               index.m_ids[game_idx]);
+    }
+    sums[bag_idx] = tree.get_prefix_sum(get_rank(greens, bag.m_green),
+                                        get_rank(blues, bag.m_blue));
+  }
+  return sums;
+}
+
+#ifndef AOC_NO_MAIN
+int
+run_queries(char const *bags_path, char const *path) {
+  std::vector<GameSet> bags;
+  std::vector<std::string> bag_lines;
+  if (!read_input_file(bags_path, bag_lines)) {
+    std::println(stderr, "couldn't read file {}", bags_path);
+    return 1;
+  }
+  for (auto const &[line_idx, line] : std::views::enumerate(bag_lines)) {
+    std::optional<GameSet> const bag = parse_bag(line);
+    if (!bag) {
+      std::println(stderr,
+                   "{}:{}: expected \"red green blue\", got \"{}\"",
+                   bags_path,
+                   line_idx + 1,
+                   line);
+      return 1;
+    }
+    bags.push_back(*bag);
+  }
+  std::vector<std::string> lines;
+  if (!read_input_file(path, lines)) {
+    std::println(stderr, "couldn't read file {}", path);
+    return 1;
+  }
+
+  auto const start = std::chrono::steady_clock::now();
+  GameIndex const index = index_games(lines);
+  std::vector<std::uint64_t> const sums =
+      get_sums_of_ids_of_possible_games(index, bags);
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+
+  std::string output;
+  for (std::uint64_t const sum : sums) {
+    output += std::format("{}\n", sum);
+  }
+  std::print("{}", output);
+  std::println(stderr,
+               "{} games, {} bags: {:.3f} ms",
+               index.m_ids.size(),
+               bags.size(),
+               static_cast<double>(
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                       .count())
+                   / 1e6);
+  return 0;
+}
+
+std::optional<GameSet>
+parse_bag(std::string_view line) {
+  std::vector<std::string_view> const counts = split(line);
+  if (counts.size() != 3) {
+    return std::nullopt;
+  }
+  std::array<std::size_t, 3> values{};
+  for (std::size_t idx = 0; idx < counts.size(); ++idx) {
+    std::string_view const count = counts[idx];
+    auto [ptr, ec] =
+        std::from_chars(count.data(), count.data() + count.size(), values[idx]);
+    if (ec != std::errc() || ptr != count.data() + count.size()) {
+      return std::nullopt;
+    }
+  }
+  return GameSet{.m_red = values[0], .m_green = values[1], .m_blue = values[2]};
+}
+#endif
+
+FenwickTree2d::FenwickTree2d(std::size_t num_rows, std::size_t num_cols)
+    : m_num_rows(num_rows),
+      m_num_cols(num_cols),
+      m_sums((num_rows + 1) * (num_cols + 1)) {}
+
+void
+FenwickTree2d::add(std::size_t row, std::size_t col, std::uint64_t value) {
+  for (std::size_t tree_row = row; tree_row <= m_num_rows;
+       tree_row += tree_row & (~tree_row + 1)) {
+    for (std::size_t tree_col = col; tree_col <= m_num_cols;
+         tree_col += tree_col & (~tree_col + 1)) {
+      m_sums[(tree_row * (m_num_cols + 1)) + tree_col] += value;
+    }
+  }
+}
+
+std::uint64_t
+FenwickTree2d::get_prefix_sum(std::size_t row, std::size_t col) const {
+  std::uint64_t sum{};
+  for (std::size_t tree_row = row; tree_row > 0;
+       tree_row -= tree_row & (~tree_row + 1)) {
+    for (std::size_t tree_col = col; tree_col > 0;
+         tree_col -= tree_col & (~tree_col + 1)) {
+      sum += m_sums[(tree_row * (m_num_cols + 1)) + tree_col];
+    }
+  }
+  return sum;
+}
+
+static_assert(get_sum_of_ids_of_possible_games(EXAMPLE, parse_game) == 8);
 } // namespace
+
+#ifdef AOC_EMBED_INPUT
+#include AOC_EMBED_INPUT // EMBEDDED_INPUT
+
+int
+main(int argc, char const **argv) {
+  static constexpr std::uint64_t ANSWER =
+      get_sum_of_ids_of_possible_games(split_lines(EMBEDDED_INPUT), parse_game);
+  return embedded_main(
+      argc, argv, 2, 1, std::format("{}", ANSWER), EMBEDDED_INPUT);
+}
+#endif
@@ -1,101 +1,172 @@
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
 #include <algorithm> // std::ranges::transform
-#include <print> // std::println
+#include <array> // std::array
+#include <format> // std::format
+#include <random> // std::mt19937_64
 #include <string> // std::string
 #include <vector> // std::vector
 
+namespace
+{
 struct GameSet
 {
   std::size_t m_red;
   std::size_t m_green;
   std::size_t m_blue;
 
-  [[nodiscard]] std::size_t
+  [[nodiscard]] constexpr std::size_t
   get_power() const;
 };
 
 struct Game
 {
   std::size_t m_id;
-  std::vector<GameSet> m_sets;
-
-  [[nodiscard]] GameSet
-  get_min_game_set() const;
+  /// the fewest cubes of each color the game could have been played with
+  GameSet m_min_game_set;
 };
 
-namespace
-{
 void
 tests();
-std::uint64_t
-get_sum_of_powers_of_min_game_sets(std::ranges::range auto &&lines);
-Game
+constexpr std::uint64_t
+get_sum_of_powers_of_min_game_sets(std::ranges::range auto &&lines,
+                                   auto parse_line);
+constexpr Game
 parse_game(std::string_view line);
-std::size_t
-parse_game_id(std::string_view game_id_line);
-std::vector<GameSet>
+constexpr Game
+parse_game_by_splitting(std::string_view line);
+constexpr std::vector<GameSet>
 parse_game_sets(std::string_view game_sets_line);
-GameSet
+constexpr GameSet
 parse_game_set(std::string_view game_set_line);
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const *const *argv) {
-  tests();
-
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  if (lines.empty()) {
-    return 1;
-  }
-
-  std::println("{}", get_sum_of_powers_of_min_game_sets(lines));
-  return 0;
+  return solver_main(argc, argv, 2, 2);
 }
+#endif
 
 namespace
 {
+SolverRegistrar const registrar{
+    {.m_day = 2,
+     .m_part = 2,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format(
+               "{}", get_sum_of_powers_of_min_game_sets(lines, parse_game));
+         },
+     .m_make_accumulator =
+         [] {
+           return make_line_sum_accumulator([](std::string_view line) {
+             return get_sum_of_powers_of_min_game_sets(std::array{line},
+                                                       parse_game);
+           });
+         },
+     .m_reference =
+         [](std::vector<std::string> const &lines) {
+           return std::format(
+               "{}",
+               get_sum_of_powers_of_min_game_sets(lines,
+                                                  parse_game_by_splitting));
+         },
+     .m_generate = generate_input,
+     .m_complexity = Complexity::LINEAR}};
+} // namespace
+
+namespace
+{
+constexpr std::array<std::string_view, 5> EXAMPLE{
+    "Game 1: 3 blue, 4 red; 1 red, 2 green, 6 blue; 2 green",
+    "Game 2: 1 blue, 2 green; 3 green, 4 blue, 1 red; 1 green, 1 blue",
+    "Game 3: 8 green, 6 blue, 20 red; 5 blue, 4 red, 13 green; 5 green, 1 red",
+    "Game 4: 1 green, 3 red, 6 blue; 3 green, 6 red; 3 green, 15 blue, 14 red",
+    "Game 5: 6 red, 1 blue, 3 green; 2 blue, 1 red, 2 green",
+};
+
 void
 tests() {
-  using namespace std::literals::string_view_literals;
-  auto const lines = std::array{
-      "Game 1: 3 blue, 4 red; 1 red, 2 green, 6 blue; 2 green"sv,
-      "Game 2: 1 blue, 2 green; 3 green, 4 blue, 1 red; 1 green, 1 blue"sv,
-      "Game 3: 8 green, 6 blue, 20 red; 5 blue, 4 red, 13 green; 5 green, 1 red"sv,
-      "Game 4: 1 green, 3 red, 6 blue; 3 green, 6 red; 3 green, 15 blue, 14 red"sv,
-      "Game 5: 6 red, 1 blue, 3 green; 2 blue, 1 red, 2 green"sv,
-  };
-  ASSERT(get_sum_of_powers_of_min_game_sets(lines) == 2286);
+  ASSERT(get_sum_of_powers_of_min_game_sets(EXAMPLE, parse_game) == 2286);
+  ASSERT(get_sum_of_powers_of_min_game_sets(EXAMPLE, parse_game_by_splitting)
+         == 2286);
 }
 
-std::uint64_t
-get_sum_of_powers_of_min_game_sets(std::ranges::range auto &&lines) {
+constexpr std::uint64_t
+get_sum_of_powers_of_min_game_sets(std::ranges::range auto &&lines,
+                                   auto parse_line) {
   std::uint64_t total{};
   for (auto const &line : lines) {
-    auto game = parse_game(line);
-    total += game.get_min_game_set().get_power();
+    total += parse_line(line).m_min_game_set.get_power();
   }
   return total;
 }
 
-Game
+/// A single pass over the line's bytes, folding every count into the running
+/// maximum of its color. The line is assumed to be well formed, as
+/// "Game <id>: <count> <color>, ...; ...", with every color one of "red",
+/// "green" and "blue": a color is then told by its first letter and skipped
+/// by its length, and the separators are skipped as they come.
+constexpr Game
 parse_game(std::string_view line) {
-  auto tokens = split(line, ": ");
-  return Game{.m_id = parse_game_id(tokens[0]),
-              .m_sets = parse_game_sets(tokens[1])};
+  constexpr std::size_t GAME_LEN{5 /*Game */};
+  Game game{.m_id = 0,
+            .m_min_game_set = {.m_red = 0, .m_green = 0, .m_blue = 0}};
+  std::size_t idx = GAME_LEN;
+  for (; idx < line.size() && is_digit(line[idx]); ++idx) {
+    game.m_id = (game.m_id * 10) + char_to_int(line[idx]);
+  }
+
+  std::size_t count{};
+  for (; idx < line.size(); ++idx) {
+    char const ch = line[idx];
+    if (is_digit(ch)) {
+      count = (count * 10) + char_to_int(ch);
+      continue;
+    }
+    GameSet &min_game_set = game.m_min_game_set;
+    switch (ch) {
+    case 'r':
+      min_game_set.m_red = std::max(min_game_set.m_red, count);
+      idx += 2 /*ed*/;
+      break;
+    case 'g':
+      min_game_set.m_green = std::max(min_game_set.m_green, count);
+      idx += 4 /*reen*/;
+      break;
+    case 'b':
+      min_game_set.m_blue = std::max(min_game_set.m_blue, count);
+      idx += 3 /*lue*/;
+      break;
+    default:
+      continue;
+    }
+    count = 0;
+  }
+  return game;
 }
 
-std::size_t
-parse_game_id(std::string_view game_id_line) {
-  static constexpr std::size_t GAME_LEN{5 /*Game */};
-  std::size_t game_id{};
-  std::from_chars(game_id_line.data() + GAME_LEN,
-                  game_id_line.data() + GAME_LEN + game_id_line.size(),
-                  game_id);
-  return game_id;
+constexpr Game
+parse_game_by_splitting(std::string_view line) {
+  constexpr std::size_t GAME_LEN{5 /*Game */};
+  auto tokens = split(line, ": ");
+  Game game{.m_id = str_to_int<std::size_t>(tokens[0].substr(GAME_LEN)),
+            .m_min_game_set = {.m_red = 0, .m_green = 0, .m_blue = 0}};
+  for (GameSet const &game_set : parse_game_sets(tokens[1])) {
+    GameSet &min_game_set = game.m_min_game_set;
+    min_game_set.m_red = std::max(min_game_set.m_red, game_set.m_red);
+    min_game_set.m_green = std::max(min_game_set.m_green, game_set.m_green);
+    min_game_set.m_blue = std::max(min_game_set.m_blue, game_set.m_blue);
+  }
+  return game;
 }
 
-std::vector<GameSet>
+constexpr std::vector<GameSet>
 parse_game_sets(std::string_view game_sets_line) {
   std::vector<GameSet> game_sets;
   auto tokens = split(game_sets_line, "; ");
@@ -103,13 +174,12 @@ parse_game_sets(std::string_view game_sets_line) {
   return game_sets;
 }
 
-GameSet
+constexpr GameSet
 parse_game_set(std::string_view game_set_line) {
   GameSet game_set{.m_red = 0, .m_green = 0, .m_blue = 0};
   for (std::string_view pair : split(game_set_line, ", ")) {
     auto tokens = split(pair);
-    std::size_t num{};
-    std::from_chars(tokens[0].data(), tokens[0].data() + tokens[0].size(), num);
+    auto const num = str_to_int<std::size_t>(tokens[0]);
     if (tokens[1] == "red") {
       game_set.m_red = num;
     } else if (tokens[1] == "green") {
@@ -120,20 +190,54 @@ parse_game_set(std::string_view game_set_line) {
   }
   return game_set;
 }
-} // namespace
 
-std::size_t
+/// `size` games of up to 6 sets of up to 20 cubes of each color, the colors
+/// in any order
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size) {
+  static constexpr std::array<std::string_view, 3> COLORS{
+      "red", "green", "blue"};
+  std::uniform_int_distribution<std::size_t> num_sets(1, 6);
+  std::uniform_int_distribution<std::size_t> count(1, 20);
+  std::bernoulli_distribution is_shown(0.7);
+  std::vector<std::string> lines;
+  for (std::size_t idx = 0; idx < size; ++idx) {
+    std::string line = std::format("Game {}:", idx + 1);
+    for (std::size_t set_idx = num_sets(rng); set_idx > 0; --set_idx) {
+      std::array colors = COLORS;
+      std::ranges::shuffle(colors, rng);
+      std::string_view separator = " ";
+      for (std::string_view const color : colors) {
+        // every set shows at least one color
+        if (is_shown(rng) || (separator == " " && color == colors.back())) {
+          line += std::format("{}{} {}", separator, count(rng), color);
+          separator = ", ";
+        }
+      }
+      line += ';';
+    }
+    line.pop_back();
+    lines.emplace_back(std::move(line));
+  }
+  return lines;
+}
+
+constexpr std::size_t
 GameSet::get_power() const {
   return m_red * m_green * m_blue;
 }
 
-GameSet
-Game::get_min_game_set() const {
-  GameSet min_game_set{.m_red = 0, .m_green = 0, .m_blue = 0};
-  for (GameSet const &game_set : m_sets) {
-    min_game_set.m_red = std::max(min_game_set.m_red, game_set.m_red);
-    min_game_set.m_green = std::max(min_game_set.m_green, game_set.m_green);
-    min_game_set.m_blue = std::max(min_game_set.m_blue, game_set.m_blue);
-  }
-  return min_game_set;
+static_assert(get_sum_of_powers_of_min_game_sets(EXAMPLE, parse_game) == 2286);
+} // namespace
+
+#ifdef AOC_EMBED_INPUT
+#include AOC_EMBED_INPUT // EMBEDDED_INPUT
+
+int
+main(int argc, char const **argv) {
+  static constexpr std::uint64_t ANSWER = get_sum_of_powers_of_min_game_sets(
+      split_lines(EMBEDDED_INPUT), parse_game);
+  return embedded_main(
+      argc, argv, 2, 2, std::format("{}", ANSWER), EMBEDDED_INPUT);
 }
+#endif
@@ -1,8 +1,18 @@
+#include "solver.hpp" // SolverRegistrar, solver_main
+#include "task_scheduler.hpp" // TaskGroup
 #include "utility.hpp"
 
 #include <algorithm> // std::ranges::fold_left
-#include <print> // std::println
+#include <array> // std::array
+#include <cmath> // std::sqrt
+#include <format> // std::format
+#include <functional> // std::plus
+#include <memory> // std::make_unique
+#include <optional> // std::optional
+#include <random> // std::mt19937_64
 #include <ranges> // std::views::enumerate
+#include <span> // std::span
+#include <sstream> // std::istringstream
 
 struct Part
 {
@@ -12,27 +22,117 @@ struct Part
   std::size_t m_len;
 };
 
+/// A bit per cell, set in the cells next to a symbol (and in the symbol's
+/// own), so that a number is a part if any of its digits' bits is set.
+/// Row r is m_words[r * m_words_per_row, (r + 1) * m_words_per_row).
+struct SymbolMask
+{
+  std::size_t m_words_per_row;
+  std::vector<u64> m_words;
+};
+
 namespace
 {
+/// The last three rows of a schematic read a row at a time, the rows above
+/// the first one being blank: a row's numbers are decided once the row below
+/// it is added.
+struct PartWindow
+{
+  std::array<std::string, 3> m_rows;
+  std::size_t m_num_rows{};
+  /// the sum of the parts of every row but the last
+  std::uint64_t m_sum{};
+};
+
+/// Sums the parts of an append-only schematic, in memory that only grows
+/// with its width.
+class PartAccumulator : public Accumulator
+{
+public:
+  void
+  add_line(std::string_view line) override;
+  [[nodiscard]] std::string
+  answer() const override;
+
+private:
+  PartWindow m_window;
+};
+
 void
 tests();
 std::uint64_t
 get_sum_of_parts(std::ranges::range auto &&lines);
+/// the rows of a band of the parallel solve: each band is a task, which
+/// builds the mask of its rows and of the two rows around them
+constexpr std::size_t BAND_ROWS{256};
+std::uint64_t
+get_sum_of_parts_parallel(std::ranges::range auto &&lines,
+                          TaskScheduler &scheduler,
+                          std::size_t band_rows = BAND_ROWS);
+/// the parts of rows [begin, end)
 std::vector<Part>
-get_parts(std::ranges::range auto &&lines);
+get_band_parts(std::ranges::range auto &&lines,
+               std::size_t begin,
+               std::size_t end);
+std::uint64_t
+get_sum_of_parts_by_scanning(std::ranges::range auto &&lines);
+/// the numbers for which check_part(part) holds
+std::vector<Part>
+get_parts(std::ranges::range auto &&lines, auto check_part);
+/// the numbers of `line`, the `row`th, for which check_part(part) holds,
+/// appended to `parts`
+void
+get_row_parts(std::string_view line,
+              std::size_t row,
+              auto check_part,
+              std::vector<Part> &parts);
+void
+add_row(PartWindow &window, std::string_view line);
+std::uint64_t
+get_sum_of_part_nums(std::vector<Part> const &parts);
+SymbolMask
+get_symbol_mask(std::ranges::range auto &&lines);
+bool
+is_part(Part const &part, SymbolMask const &mask);
 bool
-is_part(Part const &part, std::ranges::range auto &&lines);
+is_part_by_scanning(Part const &part, std::ranges::range auto &&lines);
 bool
 is_symbol(char ch);
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size);
+/// streamed through a PartAccumulator, in memory that only grows with the
+/// width of the schematic
+std::optional<std::string>
+solve_file(char const *path);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_sum_of_parts(lines));
-  return 0;
+  return solver_main(argc, argv, 3, 1);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 3,
+     .m_part = 1,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format(
+               "{}", get_sum_of_parts_parallel(lines, default_scheduler()));
+         },
+     .m_solve_file = solve_file,
+     .m_make_accumulator = [] { return std::make_unique<PartAccumulator>(); },
+     .m_reference =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}", get_sum_of_parts_by_scanning(lines));
+         },
+     .m_generate = generate_input,
+     .m_complexity = Complexity::LINEAR}};
+} // namespace
 
 namespace
 {
@@ -52,11 +152,108 @@ tests() {
       ".664.598.."sv,
   };
   ASSERT(get_sum_of_parts(lines) == 4361);
+  ASSERT(get_sum_of_parts_by_scanning(lines) == 4361);
+  for (std::size_t band_rows = 1; band_rows <= lines.size(); ++band_rows) {
+    ASSERT(get_sum_of_parts_parallel(lines, default_scheduler(), band_rows)
+           == 4361);
+  }
+
+  PartAccumulator accumulator;
+  for (auto const &[row, line] : std::views::enumerate(lines)) {
+    accumulator.add_line(line);
+    // as if the schematic ended there
+    ASSERT(accumulator.answer()
+           == std::format("{}",
+                          get_sum_of_parts(std::span(lines).first(
+                              static_cast<std::size_t>(row) + 1))));
+  }
+
+  // the lines as solve_file() feeds them, but from memory
+  std::string contents;
+  for (std::string_view const line : lines) {
+    contents += line;
+    contents += '\n';
+  }
+  std::istringstream input(contents);
+  PartAccumulator stream_accumulator;
+  ASSERT(accumulate_input(input, stream_accumulator) == "4361");
+
+  // numbers across the boundary of the mask's words, touching a symbol only
+  // diagonally, or not at all
+  std::string line_above(130, '.');
+  std::string line(130, '.');
+  line.replace(62, 4, "1234");
+  line_above[66] = '#';
+  line.replace(120, 2, "56");
+  line_above[123] = '#';
+  auto const wide_lines = std::array{line_above, line};
+  ASSERT(get_sum_of_parts(wide_lines) == 1234);
+  ASSERT(get_sum_of_parts_by_scanning(wide_lines) == 1234);
+  ASSERT(get_sum_of_parts_parallel(wide_lines, default_scheduler(), 1)
+         == 1234);
 }
 
 std::uint64_t
 get_sum_of_parts(std::ranges::range auto &&lines) {
-  std::vector<Part> parts = get_parts(lines);
+  SymbolMask const mask = get_symbol_mask(lines);
+  return get_sum_of_part_nums(get_parts(
+      lines, [&mask](Part const &part) { return is_part(part, mask); }));
+}
+
+std::uint64_t
+get_sum_of_parts_parallel(std::ranges::range auto &&lines,
+                          TaskScheduler &scheduler,
+                          std::size_t band_rows) {
+  std::size_t const num_rows = std::ranges::size(lines);
+  std::size_t const num_bands = (num_rows + band_rows - 1) / band_rows;
+  // added up in order of band, whichever band is done first
+  std::vector<std::uint64_t> band_sums(num_bands);
+  TaskGroup group(scheduler);
+  for (std::size_t band = 0; band < num_bands; ++band) {
+    group.spawn([&, band] {
+      std::size_t const begin = band * band_rows;
+      band_sums[band] = get_sum_of_part_nums(
+          get_band_parts(lines, begin, std::min(begin + band_rows, num_rows)));
+    });
+  }
+  group.wait();
+  return std::ranges::fold_left(band_sums, 0ULL, std::plus{});
+}
+
+/// The mask takes in a halo of the row above the band and the row below it,
+/// but only the numbers of the band's own rows are checked against it: as a
+/// number is on a single row, it is the part of a single band.
+std::vector<Part>
+get_band_parts(std::ranges::range auto &&lines,
+               std::size_t begin,
+               std::size_t end) {
+  std::size_t const halo_begin = begin == 0 ? 0 : begin - 1;
+  std::size_t const halo_end = std::min(end + 1, std::ranges::size(lines));
+  SymbolMask const mask = get_symbol_mask(
+      std::span(lines).subspan(halo_begin, halo_end - halo_begin));
+  std::vector<Part> parts;
+  for (std::size_t row = begin; row < end; ++row) {
+    get_row_parts(
+        lines[row],
+        row - halo_begin,
+        [&mask](Part const &part) { return is_part(part, mask); },
+        parts);
+  }
+  for (Part &part : parts) {
+    part.m_row += halo_begin;
+  }
+  return parts;
+}
+
+std::uint64_t
+get_sum_of_parts_by_scanning(std::ranges::range auto &&lines) {
+  return get_sum_of_part_nums(get_parts(lines, [&lines](Part const &part) {
+    return is_part_by_scanning(part, lines);
+  }));
+}
+
+std::uint64_t
+get_sum_of_part_nums(std::vector<Part> const &parts) {
   std::size_t total =
       std::ranges::fold_left(parts,
                              0ULL,
@@ -67,34 +264,122 @@ get_sum_of_parts(std::ranges::range auto &&lines) {
 }
 
 std::vector<Part>
-get_parts(std::ranges::range auto &&lines) {
+get_parts(std::ranges::range auto &&lines, auto check_part) {
   std::vector<Part> parts;
-  std::size_t const line_length{lines.front().size()};
+  for (auto const &[row, line] : std::views::enumerate(lines)) {
+    get_row_parts(line, static_cast<std::size_t>(row), check_part, parts);
+  }
+  return parts;
+}
+
+void
+get_row_parts(std::string_view line,
+              std::size_t row,
+              auto check_part,
+              std::vector<Part> &parts) {
+  std::size_t const line_length{line.size()};
+  for (std::size_t col = 0; col < line_length; ++col) {
+    std::size_t length = 0;
+    while (col < line_length && is_digit(line[col])) {
+      ++col;
+      ++length;
+    }
+    if (length != 0) {
+      std::size_t l_col = col - length;
+      Part part{str_to_int<std::uint64_t>(line.substr(l_col, length)),
+                row,
+                l_col,
+                length};
+      if (check_part(part)) {
+        parts.emplace_back(part);
+      }
+    }
+  }
+}
 
+void
+add_row(PartWindow &window, std::string_view line) {
+  if (window.m_num_rows++ == 0) {
+    window.m_rows.fill(std::string(line.size(), '.'));
+  }
+  std::ranges::rotate(window.m_rows, window.m_rows.begin() + 1);
+  window.m_rows.back().assign(line);
+
+  // the middle row now has both of its neighbours
+  std::array<std::string_view, 3> const rows{
+      window.m_rows[0], window.m_rows[1], window.m_rows[2]};
+  SymbolMask const mask = get_symbol_mask(rows);
+  std::vector<Part> parts;
+  get_row_parts(
+      rows[1],
+      1,
+      [&mask](Part const &part) { return is_part(part, mask); },
+      parts);
+  window.m_sum += get_sum_of_part_nums(parts);
+}
+
+/// A single pass over the grid: every row's symbols, widened by a cell to
+/// each side, are or'ed into the row itself and into its neighbours.
+SymbolMask
+get_symbol_mask(std::ranges::range auto &&lines) {
+  std::size_t const num_rows = std::ranges::size(lines);
+  std::size_t const words_per_row = (lines.front().size() + 63) / 64;
+  SymbolMask mask{.m_words_per_row = words_per_row,
+                  .m_words = std::vector<u64>(num_rows * words_per_row)};
+  std::vector<u64> symbols(words_per_row);
   for (auto const &[row, line] : std::views::enumerate(lines)) {
-    for (std::size_t col = 0; col < line_length; ++col) {
-      std::size_t length = 0;
-      while (col < line_length && is_digit(line[col])) {
-        ++col;
-        ++length;
+    std::ranges::fill(symbols, 0);
+    for (auto const &[col, ch] : std::views::enumerate(line)) {
+      if (is_symbol(ch)) {
+        auto const idx = static_cast<std::size_t>(col);
+        symbols[idx / 64] |= u64{1} << (idx % 64);
       }
-      if (length != 0) {
-        std::size_t l_col = col - length;
-        Part part{str_to_int<std::uint64_t>(line.substr(l_col, length)),
-                  static_cast<std::size_t>(row),
-                  l_col,
-                  length};
-        if (is_part(part, lines)) {
-          parts.emplace_back(part);
-        }
+    }
+
+    auto const row_idx = static_cast<std::size_t>(row);
+    std::size_t const first_row = row_idx == 0 ? 0 : row_idx - 1;
+    std::size_t const last_row = std::min(row_idx + 1, num_rows - 1);
+    for (std::size_t word = 0; word < words_per_row; ++word) {
+      // the bits shifted across the words' boundaries included
+      u64 const widened =
+          symbols[word] | (symbols[word] << 1) | (symbols[word] >> 1)
+          | (word > 0 ? symbols[word - 1] >> 63 : 0)
+          | (word + 1 < words_per_row ? symbols[word + 1] << 63 : 0);
+      for (std::size_t mask_row = first_row; mask_row <= last_row;
+           ++mask_row) {
+        mask.m_words[(mask_row * words_per_row) + word] |= widened;
       }
     }
   }
-  return parts;
+  return mask;
+}
+
+/// The number's bits are in one word, or in two for the few that straddle a
+/// boundary.
+bool
+is_part(Part const &part, SymbolMask const &mask) {
+  std::size_t const first_col = part.m_col;
+  std::size_t const last_col = part.m_col + part.m_len - 1;
+  auto const row_words = std::span(mask.m_words)
+                             .subspan(part.m_row * mask.m_words_per_row,
+                                      mask.m_words_per_row);
+  for (std::size_t word = first_col / 64; word <= last_col / 64; ++word) {
+    u64 bits = row_words[word];
+    if (word == first_col / 64) {
+      bits &= ~u64{0} << (first_col % 64);
+    }
+    if (word == last_col / 64) {
+      bits &= ~u64{0} >> (63 - (last_col % 64));
+    }
+    if (bits != 0) {
+      return true;
+    }
+  }
+  return false;
 }
 
 bool
-is_part(Part const &part, std::ranges::range auto &&lines) {
+is_part_by_scanning(Part const &part, std::ranges::range auto &&lines) {
   std::size_t const &row = part.m_row;
   std::size_t const &col = part.m_col;
   std::size_t const &len = part.m_len;
@@ -122,13 +407,17 @@ is_part(Part const &part, std::ranges::range auto &&lines) {
   }
   // check if previous line contains a symbol
   if (row > 0) {
-    if (std::ranges::any_of(lines[row - 1].substr(bb_col, bb_len), is_symbol)) {
+    if (std::ranges::any_of(
+            std::string_view(lines[row - 1]).substr(bb_col, bb_len),
+            is_symbol)) {
       return true;
     }
   }
   // check if next line contains a symbol
   if (row < lines.size() - 1) {
-    if (std::ranges::any_of(lines[row + 1].substr(bb_col, bb_len), is_symbol)) {
+    if (std::ranges::any_of(
+            std::string_view(lines[row + 1]).substr(bb_col, bb_len),
+            is_symbol)) {
       return true;
     }
   }
@@ -140,4 +429,55 @@ bool
 is_symbol(char ch) {
   return ch != '.' && !is_digit(ch);
 }
+
+/// a square schematic of about `size` numbers, dense with symbols, so that
+/// many of them are parts and many aren't
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size) {
+  auto const side =
+      (2 * static_cast<std::size_t>(std::sqrt(static_cast<double>(size)))) + 3;
+  std::uniform_int_distribution<int> cell(0, 9);
+  std::uniform_int_distribution<std::size_t> num_digits(1, 3);
+  std::uniform_int_distribution<int> digit(0, 9);
+  std::vector<std::string> lines(side, std::string(side, '.'));
+  for (std::string &line : lines) {
+    // a number is always followed by a '.', as the next cell is skipped
+    for (std::size_t col = 0; col < side; ++col) {
+      int const kind = cell(rng);
+      if (kind < 3) {
+        for (std::size_t len = num_digits(rng); len > 0 && col < side;
+             --len, ++col) {
+          line[col] = static_cast<char>('0' + digit(rng));
+        }
+      } else if (kind < 5) {
+        line[col] = '*';
+      } else if (kind == 5) {
+        line[col] = '#';
+      }
+    }
+  }
+  return lines;
+}
+
+std::optional<std::string>
+solve_file(char const *path) {
+  PartAccumulator accumulator;
+  return accumulate_input_file(path, accumulator);
+}
+
+void
+PartAccumulator::add_line(std::string_view line) {
+  add_row(m_window, line);
+}
+
+/// The last row's parts too, as if a blank row followed it.
+std::string
+PartAccumulator::answer() const {
+  if (m_window.m_num_rows == 0) {
+    return "0";
+  }
+  PartWindow window = m_window;
+  add_row(window, std::string(window.m_rows.back().size(), '.'));
+  return std::format("{}", window.m_sum);
+}
 } // namespace
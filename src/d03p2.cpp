@@ -1,8 +1,18 @@
+#include "solver.hpp" // SolverRegistrar, solver_main
+#include "task_scheduler.hpp" // TaskGroup
 #include "utility.hpp"
 
 #include <algorithm> // std::ranges::fold_left
-#include <print> // std::println
+#include <array> // std::array
+#include <cmath> // std::sqrt
+#include <format> // std::format
+#include <functional> // std::plus
+#include <memory> // std::make_unique
+#include <optional> // std::optional
+#include <random> // std::mt19937_64
 #include <ranges> // std::views::enumerate
+#include <span> // std::span
+#include <sstream> // std::istringstream
 
 struct Part
 {
@@ -12,6 +22,23 @@ struct Part
   std::size_t m_len;
 };
 
+/// A bit per cell, set in the cells next to a symbol (and in the symbol's
+/// own), so that a number is a part if any of its digits' bits is set.
+/// Row r is m_words[r * m_words_per_row, (r + 1) * m_words_per_row).
+struct SymbolMask
+{
+  std::size_t m_words_per_row;
+  std::vector<u64> m_words;
+};
+
+/// The parts bucketed by row: those of row r are
+/// m_parts[m_row_begins[r], m_row_begins[r + 1]), in order of column.
+struct PartIndex
+{
+  std::vector<Part> m_parts;
+  std::vector<std::size_t> m_row_begins;
+};
+
 struct Gear
 {
   std::uint64_t m_ratio;
@@ -21,29 +48,117 @@ struct Gear
 
 namespace
 {
+/// The last three rows of a schematic read a row at a time, the rows above
+/// the first one being blank. A row's numbers are decided once the row below
+/// it is added, and its gears once the numbers of the row below are, so the
+/// parts of the three rows around the gears to decide are kept too.
+struct GearWindow
+{
+  std::array<std::string, 3> m_rows;
+  /// the parts of the rows above m_rows[0], of m_rows[0] and of m_rows[1]
+  std::array<std::vector<Part>, 3> m_parts;
+  std::size_t m_num_rows{};
+  /// the sum of the ratios of the gears of every row but the last two
+  std::uint64_t m_sum{};
+};
+
+/// Sums the gear ratios of an append-only schematic, in memory that only
+/// grows with its width.
+class GearAccumulator : public Accumulator
+{
+public:
+  void
+  add_line(std::string_view line) override;
+  [[nodiscard]] std::string
+  answer() const override;
+
+private:
+  GearWindow m_window;
+};
+
 void
 tests();
 std::uint64_t
 get_sum_of_gear_ratios(std::ranges::range auto &&lines);
-std::vector<Part>
-get_parts(std::ranges::range auto &&lines);
+/// the rows of a band of the parallel solve: each band is a task, which
+/// builds the mask of its rows and of the two rows around them
+constexpr std::size_t BAND_ROWS{256};
+std::uint64_t
+get_sum_of_gear_ratios_parallel(std::ranges::range auto &&lines,
+                                TaskScheduler &scheduler,
+                                std::size_t band_rows = BAND_ROWS);
+/// the parts of rows [begin, end), m_row_begins[0] being row `begin`'s
+PartIndex
+get_band_parts(std::ranges::range auto &&lines,
+               std::size_t begin,
+               std::size_t end);
+std::uint64_t
+get_sum_of_gear_ratios_by_scanning(std::ranges::range auto &&lines);
+/// the numbers for which check_part(part) holds
+PartIndex
+get_parts(std::ranges::range auto &&lines, auto check_part);
+/// the numbers of `line`, the `row`th, for which check_part(part) holds,
+/// appended to `parts`
+void
+get_row_parts(std::string_view line,
+              std::size_t row,
+              auto check_part,
+              std::vector<Part> &parts);
+void
+add_row(GearWindow &window, std::string_view line);
+SymbolMask
+get_symbol_mask(std::ranges::range auto &&lines);
+bool
+is_part(Part const &part, SymbolMask const &mask);
 bool
-is_part(Part const &part, std::ranges::range auto &&lines);
+is_part_by_scanning(Part const &part, std::ranges::range auto &&lines);
 bool
 is_symbol(char ch);
+/// the '*' for which check_gear(gear) holds, with their ratio
 std::vector<Gear>
-get_gears(std::vector<Part> const &parts, std::ranges::range auto &&lines);
+get_gears(std::ranges::range auto &&lines, auto check_gear);
 bool
-is_gear(Gear &gear, std::vector<Part> const &parts);
+is_gear(Gear &gear, PartIndex const &index);
+bool
+is_gear_by_scanning(Gear &gear, std::vector<Part> const &parts);
+std::uint64_t
+get_sum_of_ratios(std::vector<Gear> const &gears);
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size);
+/// streamed through a GearAccumulator, in memory that only grows with the
+/// width of the schematic
+std::optional<std::string>
+solve_file(char const *path);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_sum_of_gear_ratios(lines));
-  return 0;
+  return solver_main(argc, argv, 3, 2);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 3,
+     .m_part = 2,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format(
+               "{}",
+               get_sum_of_gear_ratios_parallel(lines, default_scheduler()));
+         },
+     .m_solve_file = solve_file,
+     .m_make_accumulator = [] { return std::make_unique<GearAccumulator>(); },
+     .m_reference =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}", get_sum_of_gear_ratios_by_scanning(lines));
+         },
+     .m_generate = generate_input,
+     .m_complexity = Complexity::LINEAR}};
+} // namespace
 
 namespace
 {
@@ -63,50 +178,282 @@ tests() {
       ".664.598.."sv,
   };
   ASSERT(get_sum_of_gear_ratios(lines) == 467835);
+  ASSERT(get_sum_of_gear_ratios_by_scanning(lines) == 467835);
+  for (std::size_t band_rows = 1; band_rows <= lines.size(); ++band_rows) {
+    ASSERT(get_sum_of_gear_ratios_parallel(
+               lines, default_scheduler(), band_rows)
+           == 467835);
+  }
+
+  GearAccumulator accumulator;
+  for (auto const &[row, line] : std::views::enumerate(lines)) {
+    accumulator.add_line(line);
+    // as if the schematic ended there
+    ASSERT(accumulator.answer()
+           == std::format("{}",
+                          get_sum_of_gear_ratios(std::span(lines).first(
+                              static_cast<std::size_t>(row) + 1))));
+  }
+
+  // the lines as solve_file() feeds them, but from memory
+  std::string contents;
+  for (std::string_view const line : lines) {
+    contents += line;
+    contents += '\n';
+  }
+  std::istringstream input(contents);
+  GearAccumulator stream_accumulator;
+  ASSERT(accumulate_input(input, stream_accumulator) == "467835");
+
+  // gears on the first and the last rows
+  auto const edge_lines = std::array{
+      "2*3"sv,
+      "..."sv,
+      "5*7"sv,
+  };
+  ASSERT(get_sum_of_gear_ratios(edge_lines) == 41);
+  ASSERT(get_sum_of_gear_ratios_by_scanning(edge_lines) == 41);
+  ASSERT(get_sum_of_gear_ratios_parallel(edge_lines, default_scheduler(), 1)
+         == 41);
 }
 
 std::uint64_t
 get_sum_of_gear_ratios(std::ranges::range auto &&lines) {
-  std::vector<Part> parts = get_parts(lines);
-  std::vector<Gear> gears = get_gears(parts, lines);
-  std::size_t total =
-      std::ranges::fold_left(gears,
-                             0ULL,
-                             [](std::size_t const &sum, Gear const &gear) {
-                               return sum + gear.m_ratio;
-                             });
-  return total;
+  SymbolMask const mask = get_symbol_mask(lines);
+  PartIndex const index = get_parts(
+      lines, [&mask](Part const &part) { return is_part(part, mask); });
+  return get_sum_of_ratios(get_gears(
+      lines, [&index](Gear &gear) { return is_gear(gear, index); }));
+}
+
+/// Twice over the bands: first for their parts, merged in order of band into
+/// the index of every row, then for the gears of their rows against it, as a
+/// gear's ratio takes the parts of the rows around it, whichever band they
+/// are in. A number or a gear is on a single row, so it is a single band's.
+std::uint64_t
+get_sum_of_gear_ratios_parallel(std::ranges::range auto &&lines,
+                                TaskScheduler &scheduler,
+                                std::size_t band_rows) {
+  std::size_t const num_rows = std::ranges::size(lines);
+  std::size_t const num_bands = (num_rows + band_rows - 1) / band_rows;
+  auto const get_band_end = [&](std::size_t band) {
+    return std::min((band + 1) * band_rows, num_rows);
+  };
+
+  std::vector<PartIndex> band_parts(num_bands);
+  {
+    TaskGroup group(scheduler);
+    for (std::size_t band = 0; band < num_bands; ++band) {
+      group.spawn([&, band] {
+        band_parts[band] =
+            get_band_parts(lines, band * band_rows, get_band_end(band));
+      });
+    }
+    group.wait();
+  }
+  PartIndex index;
+  for (PartIndex const &band_index : band_parts) {
+    std::size_t const offset = index.m_parts.size();
+    for (std::size_t const row_begin :
+         std::span(band_index.m_row_begins).first(
+             band_index.m_row_begins.size() - 1)) {
+      index.m_row_begins.emplace_back(offset + row_begin);
+    }
+    append_range(index.m_parts, band_index.m_parts);
+  }
+  index.m_row_begins.emplace_back(index.m_parts.size());
+
+  // added up in order of band, whichever band is done first
+  std::vector<std::uint64_t> band_sums(num_bands);
+  TaskGroup group(scheduler);
+  for (std::size_t band = 0; band < num_bands; ++band) {
+    group.spawn([&, band] {
+      std::size_t const begin = band * band_rows;
+      band_sums[band] = get_sum_of_ratios(
+          get_gears(std::span(lines).subspan(begin, get_band_end(band) - begin),
+                    [&index, begin](Gear &gear) {
+                      gear.m_row += begin;
+                      return is_gear(gear, index);
+                    }));
+    });
+  }
+  group.wait();
+  return std::ranges::fold_left(band_sums, 0ULL, std::plus{});
 }
 
-std::vector<Part>
-get_parts(std::ranges::range auto &&lines) {
-  std::vector<Part> parts;
-  std::size_t const line_length{lines.front().size()};
+/// The mask takes in a halo of the row above the band and the row below it,
+/// but only the numbers of the band's own rows are checked against it.
+PartIndex
+get_band_parts(std::ranges::range auto &&lines,
+               std::size_t begin,
+               std::size_t end) {
+  std::size_t const halo_begin = begin == 0 ? 0 : begin - 1;
+  std::size_t const halo_end = std::min(end + 1, std::ranges::size(lines));
+  SymbolMask const mask = get_symbol_mask(
+      std::span(lines).subspan(halo_begin, halo_end - halo_begin));
+  PartIndex index;
+  for (std::size_t row = begin; row < end; ++row) {
+    index.m_row_begins.emplace_back(index.m_parts.size());
+    get_row_parts(
+        lines[row],
+        row - halo_begin,
+        [&mask](Part const &part) { return is_part(part, mask); },
+        index.m_parts);
+  }
+  index.m_row_begins.emplace_back(index.m_parts.size());
+  for (Part &part : index.m_parts) {
+    part.m_row += halo_begin;
+  }
+  return index;
+}
 
+std::uint64_t
+get_sum_of_gear_ratios_by_scanning(std::ranges::range auto &&lines) {
+  std::vector<Part> const parts =
+      get_parts(lines,
+                [&lines](Part const &part) {
+                  return is_part_by_scanning(part, lines);
+                })
+          .m_parts;
+  return get_sum_of_ratios(get_gears(lines, [&parts](Gear &gear) {
+    return is_gear_by_scanning(gear, parts);
+  }));
+}
+
+PartIndex
+get_parts(std::ranges::range auto &&lines, auto check_part) {
+  PartIndex index;
   for (auto const &[row, line] : std::views::enumerate(lines)) {
-    for (std::size_t col = 0; col < line_length; ++col) {
-      std::size_t length = 0;
-      while (col < line_length && is_digit(line[col])) {
-        ++col;
-        ++length;
+    index.m_row_begins.emplace_back(index.m_parts.size());
+    get_row_parts(
+        line, static_cast<std::size_t>(row), check_part, index.m_parts);
+  }
+  index.m_row_begins.emplace_back(index.m_parts.size());
+  return index;
+}
+
+void
+get_row_parts(std::string_view line,
+              std::size_t row,
+              auto check_part,
+              std::vector<Part> &parts) {
+  std::size_t const line_length{line.size()};
+  for (std::size_t col = 0; col < line_length; ++col) {
+    std::size_t length = 0;
+    while (col < line_length && is_digit(line[col])) {
+      ++col;
+      ++length;
+    }
+    if (length != 0) {
+      std::size_t l_col = col - length;
+      Part part{str_to_int<std::uint64_t>(line.substr(l_col, length)),
+                row,
+                l_col,
+                length};
+      if (check_part(part)) {
+        parts.emplace_back(part);
       }
-      if (length != 0) {
-        std::size_t l_col = col - length;
-        Part part{str_to_int<std::uint64_t>(line.substr(l_col, length)),
-                  static_cast<std::size_t>(row),
-                  l_col,
-                  length};
-        if (is_part(part, lines)) {
-          parts.emplace_back(part);
-        }
+    }
+  }
+}
+
+void
+add_row(GearWindow &window, std::string_view line) {
+  if (window.m_num_rows++ == 0) {
+    window.m_rows.fill(std::string(line.size(), '.'));
+  }
+  std::ranges::rotate(window.m_rows, window.m_rows.begin() + 1);
+  window.m_rows.back().assign(line);
+
+  // the middle row now has both of its neighbours
+  std::array<std::string_view, 3> const rows{
+      window.m_rows[0], window.m_rows[1], window.m_rows[2]};
+  SymbolMask const mask = get_symbol_mask(rows);
+  std::ranges::rotate(window.m_parts, window.m_parts.begin() + 1);
+  window.m_parts.back().clear();
+  get_row_parts(
+      rows[1],
+      1,
+      [&mask](Part const &part) { return is_part(part, mask); },
+      window.m_parts.back());
+
+  // and the top row the parts of both of its neighbours
+  PartIndex index;
+  for (std::vector<Part> const &row_parts : window.m_parts) {
+    index.m_row_begins.emplace_back(index.m_parts.size());
+    append_range(index.m_parts, row_parts);
+  }
+  index.m_row_begins.emplace_back(index.m_parts.size());
+  for (auto const &[col, ch] : std::views::enumerate(rows[0])) {
+    Gear gear{.m_ratio = 0, .m_row = 1, .m_col = static_cast<std::size_t>(col)};
+    if (ch == '*' && is_gear(gear, index)) {
+      window.m_sum += gear.m_ratio;
+    }
+  }
+}
+
+/// A single pass over the grid: every row's symbols, widened by a cell to
+/// each side, are or'ed into the row itself and into its neighbours.
+SymbolMask
+get_symbol_mask(std::ranges::range auto &&lines) {
+  std::size_t const num_rows = std::ranges::size(lines);
+  std::size_t const words_per_row = (lines.front().size() + 63) / 64;
+  SymbolMask mask{.m_words_per_row = words_per_row,
+                  .m_words = std::vector<u64>(num_rows * words_per_row)};
+  std::vector<u64> symbols(words_per_row);
+  for (auto const &[row, line] : std::views::enumerate(lines)) {
+    std::ranges::fill(symbols, 0);
+    for (auto const &[col, ch] : std::views::enumerate(line)) {
+      if (is_symbol(ch)) {
+        auto const idx = static_cast<std::size_t>(col);
+        symbols[idx / 64] |= u64{1} << (idx % 64);
+      }
+    }
+
+    auto const row_idx = static_cast<std::size_t>(row);
+    std::size_t const first_row = row_idx == 0 ? 0 : row_idx - 1;
+    std::size_t const last_row = std::min(row_idx + 1, num_rows - 1);
+    for (std::size_t word = 0; word < words_per_row; ++word) {
+      // the bits shifted across the words' boundaries included
+      u64 const widened =
+          symbols[word] | (symbols[word] << 1) | (symbols[word] >> 1)
+          | (word > 0 ? symbols[word - 1] >> 63 : 0)
+          | (word + 1 < words_per_row ? symbols[word + 1] << 63 : 0);
+      for (std::size_t mask_row = first_row; mask_row <= last_row;
+           ++mask_row) {
+        mask.m_words[(mask_row * words_per_row) + word] |= widened;
       }
     }
   }
-  return parts;
+  return mask;
 }
 
+/// The number's bits are in one word, or in two for the few that straddle a
+/// boundary.
 bool
-is_part(Part const &part, std::ranges::range auto &&lines) {
+is_part(Part const &part, SymbolMask const &mask) {
+  std::size_t const first_col = part.m_col;
+  std::size_t const last_col = part.m_col + part.m_len - 1;
+  auto const row_words = std::span(mask.m_words)
+                             .subspan(part.m_row * mask.m_words_per_row,
+                                      mask.m_words_per_row);
+  for (std::size_t word = first_col / 64; word <= last_col / 64; ++word) {
+    u64 bits = row_words[word];
+    if (word == first_col / 64) {
+      bits &= ~u64{0} << (first_col % 64);
+    }
+    if (word == last_col / 64) {
+      bits &= ~u64{0} >> (63 - (last_col % 64));
+    }
+    if (bits != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool
+is_part_by_scanning(Part const &part, std::ranges::range auto &&lines) {
   std::size_t const &row = part.m_row;
   std::size_t const &col = part.m_col;
   std::size_t const &len = part.m_len;
@@ -134,13 +481,17 @@ is_part(Part const &part, std::ranges::range auto &&lines) {
   }
   // check if previous line contains a symbol
   if (row > 0) {
-    if (std::ranges::any_of(lines[row - 1].substr(bb_col, bb_len), is_symbol)) {
+    if (std::ranges::any_of(
+            std::string_view(lines[row - 1]).substr(bb_col, bb_len),
+            is_symbol)) {
       return true;
     }
   }
   // check if next line contains a symbol
   if (row < lines.size() - 1) {
-    if (std::ranges::any_of(lines[row + 1].substr(bb_col, bb_len), is_symbol)) {
+    if (std::ranges::any_of(
+            std::string_view(lines[row + 1]).substr(bb_col, bb_len),
+            is_symbol)) {
       return true;
     }
   }
@@ -154,7 +505,7 @@ is_symbol(char ch) {
 }
 
 std::vector<Gear>
-get_gears(std::vector<Part> const &parts, std::ranges::range auto &&lines) {
+get_gears(std::ranges::range auto &&lines, auto check_gear) {
   std::vector<Gear> gears;
   for (auto const &[row, line] : std::views::enumerate(lines)) {
     for (auto const &[col, ch] : std::views::enumerate(line)) {
@@ -165,7 +516,7 @@ get_gears(std::vector<Part> const &parts, std::ranges::range auto &&lines) {
       Gear gear{.m_ratio = 0,
                 .m_row = static_cast<std::size_t>(row),
                 .m_col = static_cast<std::size_t>(col)};
-      if (is_gear(gear, parts)) {
+      if (check_gear(gear)) {
         gears.emplace_back(gear);
       }
     }
@@ -173,12 +524,45 @@ get_gears(std::vector<Part> const &parts, std::ranges::range auto &&lines) {
   return gears;
 }
 
+/// Only the parts of the rows around the gear: as those of a row are in order
+/// of column and don't overlap, the ones touching the gear's columns are a
+/// run found by binary search.
+bool
+is_gear(Gear &gear, PartIndex const &index) {
+  std::uint64_t count{};
+  gear.m_ratio = 1;
+  std::size_t const num_rows = index.m_row_begins.size() - 1;
+  std::size_t const first_row = gear.m_row == 0 ? 0 : gear.m_row - 1;
+  std::size_t const last_row = std::min(gear.m_row + 1, num_rows - 1);
+  for (std::size_t row = first_row; row <= last_row; ++row) {
+    auto const row_parts = std::span(index.m_parts)
+                               .subspan(index.m_row_begins[row],
+                                        index.m_row_begins[row + 1]
+                                            - index.m_row_begins[row]);
+    // from the first part that reaches the column left of the gear
+    for (auto part_it = std::ranges::partition_point(
+             row_parts,
+             [&gear](Part const &part) {
+               return part.m_col + part.m_len < gear.m_col;
+             });
+         part_it != row_parts.end() && part_it->m_col <= gear.m_col + 1;
+         ++part_it) {
+      ++count;
+      if (count > 2) {
+        return false;
+      }
+      gear.m_ratio *= part_it->m_part_num;
+    }
+  }
+  return count == 2;
+}
+
 bool
-is_gear(Gear &gear, std::vector<Part> const &parts) {
+is_gear_by_scanning(Gear &gear, std::vector<Part> const &parts) {
   std::uint64_t count{};
   gear.m_ratio = 1;
   for (Part const &part : std::views::filter(parts, [&gear](Part const &part) {
-         return part.m_row >= gear.m_row - 1 && part.m_row <= gear.m_row + 1
+         return part.m_row + 1 >= gear.m_row && part.m_row <= gear.m_row + 1
                 && part.m_col + part.m_len >= gear.m_col
                 && part.m_col <= gear.m_col + 1;
        })) {
@@ -191,4 +575,67 @@ is_gear(Gear &gear, std::vector<Part> const &parts) {
   return count == 2;
 }
 
+std::uint64_t
+get_sum_of_ratios(std::vector<Gear> const &gears) {
+  std::size_t total =
+      std::ranges::fold_left(gears,
+                             0ULL,
+                             [](std::size_t const &sum, Gear const &gear) {
+                               return sum + gear.m_ratio;
+                             });
+  return total;
+}
+
+/// a square schematic of about `size` numbers, dense with '*', so that many
+/// of them touch one, two or more numbers
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size) {
+  auto const side =
+      (2 * static_cast<std::size_t>(std::sqrt(static_cast<double>(size)))) + 3;
+  std::uniform_int_distribution<int> cell(0, 9);
+  std::uniform_int_distribution<std::size_t> num_digits(1, 3);
+  std::uniform_int_distribution<int> digit(0, 9);
+  std::vector<std::string> lines(side, std::string(side, '.'));
+  for (std::string &line : lines) {
+    // a number is always followed by a '.', as the next cell is skipped
+    for (std::size_t col = 0; col < side; ++col) {
+      int const kind = cell(rng);
+      if (kind < 3) {
+        for (std::size_t len = num_digits(rng); len > 0 && col < side;
+             --len, ++col) {
+          line[col] = static_cast<char>('0' + digit(rng));
+        }
+      } else if (kind < 5) {
+        line[col] = '*';
+      } else if (kind == 5) {
+        line[col] = '#';
+      }
+    }
+  }
+  return lines;
+}
+
+std::optional<std::string>
+solve_file(char const *path) {
+  GearAccumulator accumulator;
+  return accumulate_input_file(path, accumulator);
+}
+
+void
+GearAccumulator::add_line(std::string_view line) {
+  add_row(m_window, line);
+}
+
+/// The gears of the last two rows too, as if two blank rows followed them.
+std::string
+GearAccumulator::answer() const {
+  if (m_window.m_num_rows == 0) {
+    return "0";
+  }
+  GearWindow window = m_window;
+  std::string const blank_row(window.m_rows.back().size(), '.');
+  add_row(window, blank_row);
+  add_row(window, blank_row);
+  return std::format("{}", window.m_sum);
+}
 } // namespace
@@ -1,65 +1,204 @@
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
-#include <algorithm> // std::ranges::count_if
-#include <print> // std::println
+#include <algorithm> // std::ranges::binary_search
+#include <array> // std::array
+#include <bit> // std::popcount
+#include <format> // std::format
+#include <optional> // std::optional
+#include <random> // std::mt19937_64
 #include <ranges> // std::views::transform
-#include <set> // std::set
+#include <vector> // std::vector
 
 namespace
 {
+/// a bit per number of a card, for the numbers below 128, which are all the
+/// numbers real cards have
+using NumberBits = std::array<u64, 2>;
+
 void
 tests();
-std::uint64_t
-get_sum_of_points(std::ranges::range auto &&lines);
+constexpr std::uint64_t
+get_sum_of_points(std::ranges::range auto &&lines, auto get_matches);
+constexpr std::size_t
+get_num_matches(std::string_view line);
+/// nullopt when a number of the card doesn't fit in a NumberBits
+constexpr std::optional<std::size_t>
+get_num_matches_by_bits(std::string_view line);
+constexpr std::size_t
+get_num_matches_by_sorting(std::string_view line);
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_sum_of_points(lines));
-  return 0;
+  return solver_main(argc, argv, 4, 1);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 4,
+     .m_part = 1,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}", get_sum_of_points(lines, get_num_matches));
+         },
+     .m_make_accumulator =
+         [] {
+           return make_line_sum_accumulator([](std::string_view line) {
+             return get_sum_of_points(std::array{line}, get_num_matches);
+           });
+         },
+     .m_reference =
+         [](std::vector<std::string> const &lines) {
+           return std::format(
+               "{}", get_sum_of_points(lines, get_num_matches_by_sorting));
+         },
+     .m_generate = generate_input,
+     .m_complexity = Complexity::LINEAR}};
+} // namespace
 
 namespace
 {
+constexpr std::array<std::string_view, 6> EXAMPLE{
+    "Card 1: 41 48 83 86 17 | 83 86  6 31 17  9 48 53",
+    "Card 2: 13 32 20 16 61 | 61 30 68 82 17 32 24 19",
+    "Card 3:  1 21 53 59 44 | 69 82 63 72 16 21 14  1",
+    "Card 4: 41 92 73 84 69 | 59 84 76 51 58  5 54 83",
+    "Card 5: 87 83 26 28 32 | 88 30 70 12 93 22 82 36",
+    "Card 6: 31 18 13 56 72 | 74 77 10 23 35 67 36 11",
+};
+
 void
 tests() {
-  using namespace std::literals::string_view_literals;
-  auto const lines = std::array{
-      "Card 1: 41 48 83 86 17 | 83 86  6 31 17  9 48 53"sv,
-      "Card 2: 13 32 20 16 61 | 61 30 68 82 17 32 24 19"sv,
-      "Card 3:  1 21 53 59 44 | 69 82 63 72 16 21 14  1"sv,
-      "Card 4: 41 92 73 84 69 | 59 84 76 51 58  5 54 83"sv,
-      "Card 5: 87 83 26 28 32 | 88 30 70 12 93 22 82 36"sv,
-      "Card 6: 31 18 13 56 72 | 74 77 10 23 35 67 36 11"sv,
-  };
-  ASSERT(get_sum_of_points(lines) == 13);
+  ASSERT(get_sum_of_points(EXAMPLE, get_num_matches) == 13);
+  ASSERT(get_sum_of_points(EXAMPLE, get_num_matches_by_sorting) == 13);
+  // numbers on both sides of a word's boundary, a held number twice, and
+  // numbers too large for the bits
+  ASSERT(get_num_matches("Card 1: 63 64 127 | 127 64 64 1") == 2);
+  ASSERT(get_num_matches("Card 1: 5 128 | 128 5 6") == 2);
+  ASSERT(!get_num_matches_by_bits("Card 1: 5 128 | 128 5 6"));
 }
 
-std::uint64_t
-get_sum_of_points(std::ranges::range auto &&lines) {
+constexpr std::uint64_t
+get_sum_of_points(std::ranges::range auto &&lines, auto get_matches) {
   std::uint64_t total{};
   for (auto const &line : lines) {
-    auto card_id_to_numbers = split(line, ": ");
-    auto winning_and_have_numbers = split(card_id_to_numbers[1], " | ");
-    auto const winning_numbers =
-        std::views::transform(split(winning_and_have_numbers[0]),
-                              str_to_int<std::size_t>)
-        | std::ranges::to<std::set>();
-    auto const have_numbers =
-        std::views::transform(split(winning_and_have_numbers[1]),
-                              str_to_int<std::size_t>)
-        | std::ranges::to<std::set>();
-    auto count = static_cast<std::size_t>(std::ranges::count_if(
-        have_numbers,
-        [&winning_numbers](std::size_t const &have_number) {
-          return winning_numbers.contains(have_number);
-        }));
-    if (count > 0) {
+    if (std::size_t const count = get_matches(line); count > 0) {
       total += 1ULL << (count - 1ULL);
     }
   }
   return total;
 }
+
+constexpr std::size_t
+get_num_matches(std::string_view line) {
+  if (std::optional<std::size_t> const count = get_num_matches_by_bits(line)) {
+    return *count;
+  }
+  return get_num_matches_by_sorting(line);
+}
+
+/// A single pass over the card's bytes, into the bits of its winning numbers
+/// and of the numbers it has, whose matches are then the bits set in both.
+constexpr std::optional<std::size_t>
+get_num_matches_by_bits(std::string_view line) {
+  NumberBits winning{};
+  NumberBits have{};
+  NumberBits *numbers = &winning;
+  std::size_t idx = line.find(':') + 1;
+  while (idx < line.size()) {
+    if (line[idx] == '|') {
+      numbers = &have;
+    }
+    if (!is_digit(line[idx])) {
+      ++idx;
+      continue;
+    }
+    std::size_t number{};
+    for (; idx < line.size() && is_digit(line[idx]); ++idx) {
+      number = (10 * number) + char_to_int(line[idx]);
+      if (number >= 64 * winning.size()) {
+        return std::nullopt;
+      }
+    }
+    (*numbers)[number / 64] |= u64{1} << (number % 64);
+  }
+
+  std::size_t count{};
+  for (std::size_t word = 0; word < winning.size(); ++word) {
+    count +=
+        static_cast<std::size_t>(std::popcount(winning[word] & have[word]));
+  }
+  return count;
+}
+
+constexpr std::size_t
+get_num_matches_by_sorting(std::string_view line) {
+  auto card_id_to_numbers = split(line, ": ");
+  auto winning_and_have_numbers = split(card_id_to_numbers[1], " | ");
+  // sorted vectors, as a std::set can't be used in a constant expression
+  auto winning_numbers =
+      std::views::transform(split(winning_and_have_numbers[0]),
+                            str_to_int<std::size_t>)
+      | std::ranges::to<std::vector>();
+  std::ranges::sort(winning_numbers);
+  auto have_numbers =
+      std::views::transform(split(winning_and_have_numbers[1]),
+                            str_to_int<std::size_t>)
+      | std::ranges::to<std::vector>();
+  std::ranges::sort(have_numbers);
+  auto const [first_duplicate, last_duplicate] =
+      std::ranges::unique(have_numbers);
+  have_numbers.erase(first_duplicate, last_duplicate);
+  return static_cast<std::size_t>(std::ranges::count_if(
+      have_numbers,
+      [&winning_numbers](std::size_t const &have_number) {
+        return std::ranges::binary_search(winning_numbers, have_number);
+      }));
+}
+
+/// `size` cards of 10 winning numbers and 25 numbers they have, about one in
+/// a hundred of them with a number too large for the bits
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size) {
+  std::uniform_int_distribution<std::size_t> number(1, 99);
+  std::uniform_int_distribution<std::size_t> large_number(128, 999);
+  std::bernoulli_distribution is_large(0.0003);
+  auto const get_number = [&] {
+    return is_large(rng) ? large_number(rng) : number(rng);
+  };
+  std::vector<std::string> lines;
+  for (std::size_t card = 1; card <= size; ++card) {
+    std::string line = std::format("Card {:3}:", card);
+    for (std::size_t idx = 0; idx < 10; ++idx) {
+      line += std::format(" {:2}", get_number());
+    }
+    line += " |";
+    for (std::size_t idx = 0; idx < 25; ++idx) {
+      line += std::format(" {:2}", get_number());
+    }
+    lines.emplace_back(std::move(line));
+  }
+  return lines;
+}
+
+static_assert(get_sum_of_points(EXAMPLE, get_num_matches) == 13);
 } // namespace
+
+#ifdef AOC_EMBED_INPUT
+#include AOC_EMBED_INPUT // EMBEDDED_INPUT
+
+int
+main(int argc, char const **argv) {
+  static constexpr std::uint64_t ANSWER =
+      get_sum_of_points(split_lines(EMBEDDED_INPUT), get_num_matches);
+  return embedded_main(
+      argc, argv, 4, 1, std::format("{}", ANSWER), EMBEDDED_INPUT);
+}
+#endif
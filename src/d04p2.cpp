@@ -1,68 +1,158 @@
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
-#include <algorithm> // std::ranges::count_if
-#include <print> // std::println
+#include <algorithm> // std::ranges::binary_search
+#include <array> // std::array
+#include <bit> // std::popcount
+#include <deque> // std::deque
+#include <format> // std::format
+#include <memory> // std::make_unique
+#include <optional> // std::optional
+#include <random> // std::mt19937_64
 #include <ranges> // std::views::transform
-#include <set> // std::set
+#include <vector> // std::vector
 
 namespace
 {
+/// Counts the cards of an append-only input. A card's copies go to a run of
+/// the next cards no longer than its number of matches, so only the
+/// differences of the copies of a window that wide are kept, as in
+/// get_final_num_of_cards(), never the whole table.
+class CardAccumulator : public Accumulator
+{
+public:
+  void
+  add_line(std::string_view line) override;
+  [[nodiscard]] std::string
+  answer() const override;
+
+private:
+  /// the differences of the copies won by the next cards, the next one first
+  std::deque<std::uint64_t> m_copy_diffs;
+  /// the copies won by the last card added
+  std::uint64_t m_won_copies{0};
+  std::uint64_t m_num_cards{0};
+};
+
+/// a bit per number of a card, for the numbers below 128, which are all the
+/// numbers real cards have
+using NumberBits = std::array<u64, 2>;
+
 void
 tests();
-std::uint64_t
-get_final_num_of_cards(std::ranges::range auto &&lines);
+constexpr std::uint64_t
+get_final_num_of_cards(std::ranges::range auto &&lines, auto get_matches);
+constexpr std::uint64_t
+get_final_num_of_cards_by_cascading(std::ranges::range auto &&lines,
+                                    auto get_matches);
+/// the cards streamed through a CardAccumulator
+std::optional<std::string>
+solve_file(char const *path);
+constexpr std::size_t
+get_num_matches(std::string_view line);
+/// nullopt when a number of the card doesn't fit in a NumberBits
+constexpr std::optional<std::size_t>
+get_num_matches_by_bits(std::string_view line);
+constexpr std::size_t
+get_num_matches_by_sorting(std::string_view line);
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_final_num_of_cards(lines));
-  return 0;
+  return solver_main(argc, argv, 4, 2);
 }
+#endif
 
 namespace
 {
+SolverRegistrar const registrar{
+    {.m_day = 4,
+     .m_part = 2,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}",
+                              get_final_num_of_cards(lines, get_num_matches));
+         },
+     .m_solve_file = solve_file,
+     .m_make_accumulator = [] { return std::make_unique<CardAccumulator>(); },
+     .m_reference =
+         [](std::vector<std::string> const &lines) {
+           return std::format(
+               "{}",
+               get_final_num_of_cards_by_cascading(lines,
+                                                   get_num_matches_by_sorting));
+         },
+     .m_generate = generate_input,
+     .m_complexity = Complexity::LINEAR}};
+} // namespace
+
+namespace
+{
+constexpr std::array<std::string_view, 6> EXAMPLE{
+    "Card 1: 41 48 83 86 17 | 83 86  6 31 17  9 48 53",
+    "Card 2: 13 32 20 16 61 | 61 30 68 82 17 32 24 19",
+    "Card 3:  1 21 53 59 44 | 69 82 63 72 16 21 14  1",
+    "Card 4: 41 92 73 84 69 | 59 84 76 51 58  5 54 83",
+    "Card 5: 87 83 26 28 32 | 88 30 70 12 93 22 82 36",
+    "Card 6: 31 18 13 56 72 | 74 77 10 23 35 67 36 11",
+};
+
 void
 tests() {
-  using namespace std::literals::string_view_literals;
-  auto const lines = std::array{
-      "Card 1: 41 48 83 86 17 | 83 86  6 31 17  9 48 53"sv,
-      "Card 2: 13 32 20 16 61 | 61 30 68 82 17 32 24 19"sv,
-      "Card 3:  1 21 53 59 44 | 69 82 63 72 16 21 14  1"sv,
-      "Card 4: 41 92 73 84 69 | 59 84 76 51 58  5 54 83"sv,
-      "Card 5: 87 83 26 28 32 | 88 30 70 12 93 22 82 36"sv,
-      "Card 6: 31 18 13 56 72 | 74 77 10 23 35 67 36 11"sv,
-  };
-  ASSERT(get_final_num_of_cards(lines) == 30);
+  ASSERT(get_final_num_of_cards(EXAMPLE, get_num_matches) == 30);
+  ASSERT(get_final_num_of_cards(EXAMPLE, get_num_matches_by_sorting) == 30);
+  ASSERT(get_final_num_of_cards_by_cascading(EXAMPLE, get_num_matches) == 30);
+  // numbers on both sides of a word's boundary, a held number twice, and
+  // numbers too large for the bits
+  ASSERT(get_num_matches("Card 1: 63 64 127 | 127 64 64 1") == 2);
+  ASSERT(get_num_matches("Card 1: 5 128 | 128 5 6") == 2);
+  ASSERT(!get_num_matches_by_bits("Card 1: 5 128 | 128 5 6"));
+
+  CardAccumulator accumulator;
+  for (std::string_view const line : EXAMPLE) {
+    accumulator.add_line(line);
+  }
+  ASSERT(accumulator.answer() == "30");
 }
 
-std::uint64_t
-get_final_num_of_cards(std::ranges::range auto &&lines) {
-  std::vector<std::size_t> winning_cards;
-  for (auto const &line : lines) {
-    auto card_id_to_numbers = split(line, ": ");
-    auto winning_and_have_numbers = split(card_id_to_numbers[1], " | ");
-    auto const winning_numbers =
-        std::views::transform(split(winning_and_have_numbers[0]),
-                              str_to_int<std::size_t>)
-        | std::ranges::to<std::set>();
-    auto const have_numbers =
-        std::views::transform(split(winning_and_have_numbers[1]),
-                              str_to_int<std::size_t>)
-        | std::ranges::to<std::set>();
-    auto count = static_cast<std::size_t>(std::ranges::count_if(
-        have_numbers,
-        [&winning_numbers](std::size_t const &have_number) {
-          return winning_numbers.contains(have_number);
-        }));
-    winning_cards.emplace_back(count);
+/// A card's copies go to a run of the next cards, added to a difference array
+/// at both ends of the run instead of card by card: the copies a card won are
+/// then the running sum of the differences up to it.
+constexpr std::uint64_t
+get_final_num_of_cards(std::ranges::range auto &&lines, auto get_matches) {
+  std::size_t const num_cards = std::ranges::size(lines);
+  // one past the last card too, where the runs up to it end; a difference
+  // may wrap around, but the running sums are the copies themselves
+  std::vector<std::uint64_t> copy_diffs(num_cards + 1);
+  std::uint64_t won_copies{};
+  std::uint64_t total{};
+  for (auto const &[idx, line] : std::views::enumerate(lines)) {
+    auto const card = static_cast<std::size_t>(idx);
+    won_copies += copy_diffs[card];
+    std::uint64_t const copies = 1 + won_copies;
+    total += copies;
+    // no copies of the cards past the end of the table
+    std::size_t const end = std::min(card + 1 + get_matches(line), num_cards);
+    copy_diffs[card + 1] += copies;
+    copy_diffs[end] -= copies;
   }
+  return total;
+}
 
-  std::vector<std::size_t> total_cards(winning_cards.size(), 1);
-  for (std::size_t idx = 0; idx < winning_cards.size(); ++idx) {
-    for (std::size_t sub_idx = idx + 1; sub_idx < idx + 1 + winning_cards[idx];
-         ++sub_idx) {
+constexpr std::uint64_t
+get_final_num_of_cards_by_cascading(std::ranges::range auto &&lines,
+                                    auto get_matches) {
+  std::size_t const num_cards = std::ranges::size(lines);
+  std::vector<std::size_t> total_cards(num_cards, 1);
+  for (auto const &[card, line] : std::views::enumerate(lines)) {
+    auto const idx = static_cast<std::size_t>(card);
+    // no copies of the cards past the end of the table
+    std::size_t const end = std::min(idx + 1 + get_matches(line), num_cards);
+    for (std::size_t sub_idx = idx + 1; sub_idx < end; ++sub_idx) {
       total_cards[sub_idx] += total_cards[idx];
     }
   }
@@ -74,4 +164,141 @@ get_final_num_of_cards(std::ranges::range auto &&lines) {
                                 std::size_t const &val) { return prev + val; });
   return total;
 }
+
+constexpr std::size_t
+get_num_matches(std::string_view line) {
+  if (std::optional<std::size_t> const count = get_num_matches_by_bits(line)) {
+    return *count;
+  }
+  return get_num_matches_by_sorting(line);
+}
+
+/// A single pass over the card's bytes, into the bits of its winning numbers
+/// and of the numbers it has, whose matches are then the bits set in both.
+constexpr std::optional<std::size_t>
+get_num_matches_by_bits(std::string_view line) {
+  NumberBits winning{};
+  NumberBits have{};
+  NumberBits *numbers = &winning;
+  std::size_t idx = line.find(':') + 1;
+  while (idx < line.size()) {
+    if (line[idx] == '|') {
+      numbers = &have;
+    }
+    if (!is_digit(line[idx])) {
+      ++idx;
+      continue;
+    }
+    std::size_t number{};
+    for (; idx < line.size() && is_digit(line[idx]); ++idx) {
+      number = (10 * number) + char_to_int(line[idx]);
+      if (number >= 64 * winning.size()) {
+        return std::nullopt;
+      }
+    }
+    (*numbers)[number / 64] |= u64{1} << (number % 64);
+  }
+
+  std::size_t count{};
+  for (std::size_t word = 0; word < winning.size(); ++word) {
+    count +=
+        static_cast<std::size_t>(std::popcount(winning[word] & have[word]));
+  }
+  return count;
+}
+
+constexpr std::size_t
+get_num_matches_by_sorting(std::string_view line) {
+  auto card_id_to_numbers = split(line, ": ");
+  auto winning_and_have_numbers = split(card_id_to_numbers[1], " | ");
+  // sorted vectors, as a std::set can't be used in a constant expression
+  auto winning_numbers =
+      std::views::transform(split(winning_and_have_numbers[0]),
+                            str_to_int<std::size_t>)
+      | std::ranges::to<std::vector>();
+  std::ranges::sort(winning_numbers);
+  auto have_numbers =
+      std::views::transform(split(winning_and_have_numbers[1]),
+                            str_to_int<std::size_t>)
+      | std::ranges::to<std::vector>();
+  std::ranges::sort(have_numbers);
+  auto const [first_duplicate, last_duplicate] =
+      std::ranges::unique(have_numbers);
+  have_numbers.erase(first_duplicate, last_duplicate);
+  return static_cast<std::size_t>(std::ranges::count_if(
+      have_numbers,
+      [&winning_numbers](std::size_t const &have_number) {
+        return std::ranges::binary_search(winning_numbers, have_number);
+      }));
+}
+
+/// `size` cards of 10 winning numbers and 25 numbers they have, about one in
+/// a hundred of them with a number too large for the bits
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size) {
+  std::uniform_int_distribution<std::size_t> number(1, 99);
+  std::uniform_int_distribution<std::size_t> large_number(128, 999);
+  std::bernoulli_distribution is_large(0.0003);
+  auto const get_number = [&] {
+    return is_large(rng) ? large_number(rng) : number(rng);
+  };
+  std::vector<std::string> lines;
+  for (std::size_t card = 1; card <= size; ++card) {
+    std::string line = std::format("Card {:3}:", card);
+    for (std::size_t idx = 0; idx < 10; ++idx) {
+      line += std::format(" {:2}", get_number());
+    }
+    line += " |";
+    for (std::size_t idx = 0; idx < 25; ++idx) {
+      line += std::format(" {:2}", get_number());
+    }
+    lines.emplace_back(std::move(line));
+  }
+  return lines;
+}
+
+static_assert(get_final_num_of_cards(EXAMPLE, get_num_matches) == 30);
+
+std::optional<std::string>
+solve_file(char const *path) {
+  CardAccumulator accumulator;
+  return accumulate_input_file(path, accumulator);
+}
+
+void
+CardAccumulator::add_line(std::string_view line) {
+  if (!m_copy_diffs.empty()) {
+    m_won_copies += m_copy_diffs.front();
+    m_copy_diffs.pop_front();
+  }
+  std::uint64_t const copies = 1 + m_won_copies;
+  m_num_cards += copies;
+
+  std::size_t const num_matches = get_num_matches(line);
+  if (num_matches == 0) {
+    return;
+  }
+  if (m_copy_diffs.size() <= num_matches) {
+    m_copy_diffs.resize(num_matches + 1);
+  }
+  m_copy_diffs[0] += copies;
+  m_copy_diffs[num_matches] -= copies;
+}
+
+std::string
+CardAccumulator::answer() const {
+  return std::format("{}", m_num_cards);
+}
 } // namespace
+
+#ifdef AOC_EMBED_INPUT
+#include AOC_EMBED_INPUT // EMBEDDED_INPUT
+
+int
+main(int argc, char const **argv) {
+  static constexpr std::uint64_t ANSWER =
+      get_final_num_of_cards(split_lines(EMBEDDED_INPUT), get_num_matches);
+  return embedded_main(
+      argc, argv, 4, 2, std::format("{}", ANSWER), EMBEDDED_INPUT);
+}
+#endif
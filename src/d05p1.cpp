@@ -1,7 +1,12 @@
 #include <algorithm> // std::ranges::sort
-#include <print> // std::println
+#include <array> // std::array
+#include <format> // std::format
+#include <random> // std::mt19937_64
 #include <ranges> // std::views::enumerate
 
+#include "generator.hpp" // Generator
+#include "model_cache.hpp" // load_model
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
 struct mapping
@@ -13,28 +18,74 @@ struct mapping
 
 namespace
 {
+/// the almanac as it is cached (see model_cache.hpp): the seeds and every map
+/// as an array of mappings sorted by source
+struct MapRef
+{
+  u64 m_offset;
+  u64 m_size;
+};
+
+struct AlmanacModel
+{
+  u64 m_seeds_offset;
+  u64 m_num_seeds;
+  u64 m_maps_offset;
+  u64 m_num_maps;
+};
+
+constexpr u32 MODEL_VERSION{1};
+
 void
 tests();
 u64
 get_min_location_for_seeds(std::vector<std::string> const &lines);
+u64
+get_min_location_for_seeds(ModelView model);
+std::string
+build_model(std::vector<std::string> const &lines);
 std::vector<std::span<std::string const>>
 get_blocks(std::vector<std::string> const &lines);
 std::vector<u64>
 parse_seeds(std::span<std::string const> lines);
-std::vector<u64>
-parse_and_map(std::span<std::string const> lines,
-              std::vector<u64> const &values);
+std::vector<mapping>
+parse_map(std::span<std::string const> lines);
+Generator<u64>
+map_values(Generator<u64> values, std::span<mapping const> map);
 u64
-convert(u64 value, std::vector<mapping> const &map);
+convert(u64 value, std::span<mapping const> map);
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_min_location_for_seeds(lines));
-  return 0;
+  return solver_main(argc, argv, 5, 1);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 5,
+     .m_part = 1,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}", get_min_location_for_seeds(lines));
+         },
+     .m_solve_file = [](char const *path) -> std::optional<std::string> {
+       std::optional<Model> const model =
+           load_model(path, "d05p1", MODEL_VERSION, build_model);
+       if (!model) {
+         return std::nullopt;
+       }
+       return std::format("{}", get_min_location_for_seeds(model->view()));
+     },
+     .m_generate = generate_input,
+     .m_complexity = Complexity::QUADRATIC}};
+} // namespace
 
 namespace
 {
@@ -80,16 +131,53 @@ tests() {
 
 u64
 get_min_location_for_seeds(std::vector<std::string> const &lines) {
+  return get_min_location_for_seeds(ModelView(build_model(lines)));
+}
+
+/// map every seed through soil, fertilizer, water, light, temperature and
+/// humidity to its location
+u64
+get_min_location_for_seeds(ModelView model) {
+  auto const &almanac = model.get<AlmanacModel>(0);
+  // one lazy stage per map, so that every seed goes all the way to its
+  // location before the next one is read
+  Generator<u64> values = from_range(
+      model.get_array<u64>(almanac.m_seeds_offset, almanac.m_num_seeds));
+  for (MapRef const &map_ref :
+       model.get_array<MapRef>(almanac.m_maps_offset, almanac.m_num_maps)) {
+    values = map_values(
+        std::move(values),
+        model.get_array<mapping>(map_ref.m_offset, map_ref.m_size));
+  }
+  return std::ranges::min(values);
+}
+
+Generator<u64>
+map_values(Generator<u64> values, std::span<mapping const> map) {
+  for (u64 const value : values) {
+    co_yield convert(value, map);
+  }
+}
+
+std::string
+build_model(std::vector<std::string> const &lines) {
   auto const blocks = get_blocks(lines);
+  ModelWriter writer;
+  u64 const root = writer.append(AlmanacModel{});
   std::vector<u64> const seeds = parse_seeds(blocks[0]);
-  auto soil = parse_and_map(blocks[1], seeds);
-  auto fertilizer = parse_and_map(blocks[2], soil);
-  auto water = parse_and_map(blocks[3], fertilizer);
-  auto light = parse_and_map(blocks[4], water);
-  auto temperature = parse_and_map(blocks[5], light);
-  auto humidity = parse_and_map(blocks[6], temperature);
-  auto location = parse_and_map(blocks[7], humidity);
-  return std::ranges::min(location);
+  u64 const seeds_offset = writer.append_array(seeds);
+  std::vector<MapRef> map_refs;
+  for (std::span<std::string const> const block : std::views::drop(blocks, 1)) {
+    std::vector<mapping> const map = parse_map(block);
+    map_refs.emplace_back(writer.append_array(map), map.size());
+  }
+  writer.overwrite(
+      root,
+      AlmanacModel{.m_seeds_offset = seeds_offset,
+                   .m_num_seeds = seeds.size(),
+                   .m_maps_offset = writer.append_array(map_refs),
+                   .m_num_maps = map_refs.size()});
+  return writer.release();
 }
 
 std::vector<std::span<std::string const>>
@@ -117,11 +205,10 @@ parse_seeds(std::span<std::string const> lines) {
          | std::ranges::to<std::vector<u64>>();
 }
 
-std::vector<u64>
-parse_and_map(std::span<std::string const> lines,
-              std::vector<u64> const &values) {
+std::vector<mapping>
+parse_map(std::span<std::string const> lines) {
   std::vector<mapping> map;
-  for (std::string const &line : lines) {
+  for (std::string const &line : std::views::drop(lines, 1)) {
     auto tokens = split(line) | std::views::transform(str_to_int<u64>);
     map.emplace_back(tokens[0], tokens[1], tokens[2]);
   }
@@ -130,14 +217,11 @@ parse_and_map(std::span<std::string const> lines,
     return left.src < right.src;
   });
 
-  return std::views::transform(
-             values,
-             [&map](u64 const &value) { return convert(value, map); })
-         | std::ranges::to<std::vector<u64>>();
+  return map;
 }
 
 u64
-convert(u64 value, std::vector<mapping> const &map) {
+convert(u64 value, std::span<mapping const> map) {
   for (mapping const &m : map) {
     if (value < m.src) {
       // value is not mapped
@@ -149,4 +233,41 @@ convert(u64 value, std::vector<mapping> const &map) {
   }
   return value;
 }
+
+/// `size` seeds, and up to `size` mappings per map, over values small enough
+/// for the seeds to often land on the edges of the mappings
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size) {
+  static constexpr std::array MAP_NAMES{"seed-to-soil",
+                                        "soil-to-fertilizer",
+                                        "fertilizer-to-water",
+                                        "water-to-light",
+                                        "light-to-temperature",
+                                        "temperature-to-humidity",
+                                        "humidity-to-location"};
+  u64 const max_value = (10 * size) + 10;
+  auto random = [&rng](u64 low, u64 high) {
+    return std::uniform_int_distribution<u64>(low, high)(rng);
+  };
+
+  std::string seeds = "seeds:";
+  for (std::size_t idx = 0; idx < size; ++idx) {
+    seeds += std::format(" {}", random(0, max_value));
+  }
+  std::vector<std::string> lines{seeds};
+  for (char const *name : MAP_NAMES) {
+    lines.emplace_back();
+    lines.emplace_back(std::format("{} map:", name));
+    std::vector<std::string> map;
+    for (u64 src = random(0, 3); src < max_value && map.size() < size;) {
+      u64 const len = random(1, 10);
+      map.emplace_back(std::format("{} {} {}", random(0, max_value), src, len));
+      src += len + random(0, 3);
+    }
+    // the almanac doesn't list them in order
+    std::ranges::shuffle(map, rng);
+    append_range(lines, map);
+  }
+  return lines;
+}
 } // namespace
@@ -1,7 +1,9 @@
 #include <algorithm> // std::ranges::sort
-#include <print> // std::println
+#include <format> // std::format
 #include <ranges> // std::views::enumerate
 
+#include "solver.hpp" // SolverRegistrar, solver_main
+#include "task_scheduler.hpp" // TaskGroup
 #include "utility.hpp"
 
 struct mapping
@@ -21,10 +23,27 @@ struct range
 
 namespace
 {
+/// the depth, in mapping layers, down to which a seed range's fragments are
+/// each followed as a task of their own; further down they're too many and
+/// too small to be worth one, and a task follows its fragment down the
+/// remaining layers itself
+constexpr std::size_t MAX_SPAWN_DEPTH{1};
+
 void
 tests();
 u64
 get_min_location_for_seeds(std::vector<std::string> const &lines);
+u64
+get_min_location_for_seeds_parallel(std::vector<std::string> const &lines,
+                                    TaskScheduler &scheduler);
+u64
+get_min_location_for_range(range const &r,
+                           std::span<std::vector<mapping> const> mappings,
+                           std::size_t depth,
+                           TaskScheduler &scheduler);
+u64
+get_min_location(std::vector<range> ranges,
+                 std::span<std::vector<mapping> const> mappings);
 std::vector<std::span<std::string const>>
 get_blocks(std::vector<std::string> const &lines);
 std::vector<range>
@@ -41,13 +60,30 @@ range
 convert(range const &r, mapping const &m);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_min_location_for_seeds(lines));
-  return 0;
+  return solver_main(argc, argv, 5, 2);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 5,
+     .m_part = 2,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format(
+               "{}",
+               get_min_location_for_seeds_parallel(lines, default_scheduler()));
+         },
+     .m_reference =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}", get_min_location_for_seeds(lines));
+         }}};
+} // namespace
 
 namespace
 {
@@ -89,23 +125,78 @@ tests() {
       "56 93 4",
   };
   ASSERT(get_min_location_for_seeds(lines) == 46);
+  ASSERT(get_min_location_for_seeds_parallel(lines, default_scheduler()) == 46);
 }
 
 u64
 get_min_location_for_seeds(std::vector<std::string> const &lines) {
   auto const blocks = get_blocks(lines);
-  std::vector<range> seed_ranges = get_seed_ranges(blocks[0]);
-  std::vector<std::vector<mapping>> mappings = get_mappings(blocks);
+  std::vector<std::vector<mapping>> const mappings = get_mappings(blocks);
+  return get_min_location(get_seed_ranges(blocks[0]), mappings);
+}
+
+u64
+get_min_location_for_seeds_parallel(std::vector<std::string> const &lines,
+                                    TaskScheduler &scheduler) {
+  auto const blocks = get_blocks(lines);
+  std::vector<range> const seed_ranges = get_seed_ranges(blocks[0]);
+  std::vector<std::vector<mapping>> const mappings = get_mappings(blocks);
+
+  std::vector<u64> min_locations(seed_ranges.size());
+  TaskGroup group(scheduler);
+  for (auto const &[idx, r] : std::views::enumerate(seed_ranges)) {
+    group.spawn([&, idx] {
+      min_locations[static_cast<std::size_t>(idx)] =
+          get_min_location_for_range(r, mappings, 0, scheduler);
+    });
+  }
+  group.wait();
+  return std::ranges::min(min_locations);
+}
 
+/// a range fragments into a different number of sub-ranges at every mapping
+/// layer, so down to MAX_SPAWN_DEPTH each fragment is followed down the
+/// remaining layers as a task of its own and the scheduler balances the
+/// uneven trees between the workers
+u64
+get_min_location_for_range(range const &r,
+                           std::span<std::vector<mapping> const> mappings,
+                           std::size_t depth,
+                           TaskScheduler &scheduler) {
+  if (mappings.empty() || depth == MAX_SPAWN_DEPTH) {
+    return get_min_location({r}, mappings);
+  }
+
+  std::vector<range> const new_ranges =
+      tranform_range_by_mapping(r, mappings.front());
+  std::vector<u64> min_locations(new_ranges.size());
+  TaskGroup group(scheduler);
+  // keep the last fragment for ourselves instead of spawning it
+  for (std::size_t idx = 0; idx + 1 < new_ranges.size(); ++idx) {
+    group.spawn([&, idx] {
+      min_locations[idx] = get_min_location_for_range(
+          new_ranges[idx], mappings.subspan(1), depth + 1, scheduler);
+    });
+  }
+  min_locations.back() = get_min_location_for_range(
+      new_ranges.back(), mappings.subspan(1), depth + 1, scheduler);
+  group.wait();
+  return std::ranges::min(min_locations);
+}
+
+/// the ranges through the mappings a layer at a time
+u64
+get_min_location(std::vector<range> ranges,
+                 std::span<std::vector<mapping> const> mappings) {
   for (std::vector<mapping> const &mapping_group : mappings) {
     std::vector<range> new_ranges;
-    for (range const &r : seed_ranges) {
+    for (range const &r : ranges) {
       new_ranges.append_range(tranform_range_by_mapping(r, mapping_group));
     }
-    seed_ranges = std::move(new_ranges);
+    ranges = std::move(new_ranges);
   }
 
-  return std::ranges::min(seed_ranges, {}, [](range const &r) { return r.src; })
+  return std::ranges::min(ranges, {}, [](range const &r) { return r.src; })
       .src;
 }
 
@@ -130,6 +221,9 @@ get_blocks(std::vector<std::string> const &lines) {
 std::vector<range>
 get_seed_ranges(std::span<std::string const> lines) {
   auto str_seeds = split(split(lines[0], "seeds: ")[0]);
+  // pairs of a start and a length, and at least one, as the minimum location
+  // of no seeds at all is undefined
+  ASSERT(!str_seeds.empty() && str_seeds.size() % 2 == 0);
   return str_seeds | std::views::transform(str_to_int<u64>)
          | std::views::chunk(2) | std::views::transform([](auto const &chunk) {
              return range{chunk[0], chunk[0] + chunk[1], chunk[1]};
@@ -1,41 +1,52 @@
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
-#include <print> // std::println
+#include <format> // std::format
 #include <ranges> // std::views::zip
 
 namespace
 {
 void
 tests();
-u64
+constexpr u64
 get_prod_of_num_ways_to_win(std::vector<std::string> const &lines);
-static std::pair<std::vector<u64>, std::vector<u64>>
+constexpr std::pair<std::vector<u64>, std::vector<u64>>
 parse_times_and_distances(std::vector<std::string> const &lines);
-u64
+constexpr u64
 num_ways_to_win(u64 const time, u64 const distance);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_prod_of_num_ways_to_win(lines));
-  return 0;
+  return solver_main(argc, argv, 6, 1);
 }
+#endif
 
 namespace
 {
+SolverRegistrar const registrar{
+    {.m_day = 6,
+     .m_part = 1,
+     .m_tests = tests,
+     .m_solve = [](std::vector<std::string> const &lines) {
+       return std::format("{}", get_prod_of_num_ways_to_win(lines));
+     }}};
+} // namespace
+
+namespace
+{
+constexpr std::string_view EXAMPLE{"Time:      7  15   30\n"
+                                   "Distance:  9  40  200\n"};
+
 void
 tests() {
-  using namespace std::literals::string_view_literals;
-  std::vector<std::string> const lines{
-      "Time:      7  15   30",
-      "Distance:  9  40  200",
-  };
-  ASSERT(get_prod_of_num_ways_to_win(lines) == 288);
+  ASSERT(get_prod_of_num_ways_to_win(split_lines(EXAMPLE)) == 288);
+  ASSERT(num_ways_to_win(3, 2) == 0);
+  ASSERT(num_ways_to_win(4, 3) == 1);
 }
 
-u64
+constexpr u64
 get_prod_of_num_ways_to_win(std::vector<std::string> const &lines) {
   auto [times, distances] = parse_times_and_distances(lines);
   u64 product{1};
@@ -45,7 +56,7 @@ get_prod_of_num_ways_to_win(std::vector<std::string> const &lines) {
   return product;
 }
 
-std::pair<std::vector<u64>, std::vector<u64>>
+constexpr std::pair<std::vector<u64>, std::vector<u64>>
 parse_times_and_distances(std::vector<std::string> const &lines) {
   return {split(split(lines[0], "Time:")[0], " ")
               | std::views::transform(str_to_int<u64>)
@@ -55,14 +66,39 @@ parse_times_and_distances(std::vector<std::string> const &lines) {
               | std::ranges::to<std::vector>()};
 }
 
-u64
+constexpr u64
 num_ways_to_win(u64 const time, u64 const distance) {
-  u64 num_ways{};
-  for (u64 t{1}; t < time; ++t) {
-    if (t * (time - t) > distance) {
-      ++num_ways;
-    }
+  // the winning hold times t, with t * (time - t) > distance, lie strictly
+  // between the roots of t^2 - time * t + distance, symmetrically around
+  // time / 2, so only the shortest one needs finding
+  if (time * time <= 4 * distance) {
+    return 0;
+  }
+  u64 hold = (time - isqrt((time * time) - (4 * distance))) / 2;
+  // the root rounds down, so the estimate may be one off either way
+  while (hold > 0 && (hold - 1) * (time - hold + 1) > distance) {
+    --hold;
+  }
+  while (hold <= time / 2 && hold * (time - hold) <= distance) {
+    ++hold;
   }
-  return num_ways;
+  if (hold > time / 2) {
+    return 0;
+  }
+  return time - (2 * hold) + 1;
 }
+
+static_assert(get_prod_of_num_ways_to_win(split_lines(EXAMPLE)) == 288);
 } // namespace
+
+#ifdef AOC_EMBED_INPUT
+#include AOC_EMBED_INPUT // EMBEDDED_INPUT
+
+int
+main(int argc, char const **argv) {
+  static constexpr u64 ANSWER =
+      get_prod_of_num_ways_to_win(split_lines(EMBEDDED_INPUT));
+  return embedded_main(
+      argc, argv, 6, 1, std::format("{}", ANSWER), EMBEDDED_INPUT);
+}
+#endif
@@ -1,9 +1,12 @@
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
 #include <algorithm> // std::ranges::sort
-#include <print> // std::println
+#include <array> // std::array
+#include <format> // std::format
+#include <functional> // std::ranges::greater
 #include <ranges> // std::views::zip
-#include <unordered_map> // std::unordered_map
+#include <string_view> // std::string_view
 
 enum HandType : u8
 {
@@ -23,54 +26,53 @@ struct Hand
   HandType type;
 };
 
-static const std::unordered_map<char, u8> CARD_VALUE{{'A', 12},
-                                                     {'K', 11},
-                                                     {'Q', 10},
-                                                     {'T', 9},
-                                                     {'9', 8},
-                                                     {'8', 7},
-                                                     {'7', 6},
-                                                     {'6', 5},
-                                                     {'5', 4},
-                                                     {'4', 3},
-                                                     {'3', 2},
-                                                     {'2', 1},
-                                                     {'J', 0}};
+/// the cards from the weakest to the strongest
+constexpr std::string_view CARDS{"J23456789TQKA"};
 
 namespace
 {
 void
 tests();
-u64
+constexpr u64
 get_total_winnings(std::vector<std::string> const &lines);
-HandType
+constexpr u8
+get_card_value(char card);
+constexpr HandType
 get_hand_type(std::string_view hand);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_total_winnings(lines));
-  return 0;
+  return solver_main(argc, argv, 7, 2);
 }
+#endif
 
 namespace
 {
+SolverRegistrar const registrar{
+    {.m_day = 7,
+     .m_part = 2,
+     .m_tests = tests,
+     .m_solve = [](std::vector<std::string> const &lines) {
+       return std::format("{}", get_total_winnings(lines));
+     }}};
+} // namespace
+
+namespace
+{
+constexpr std::string_view EXAMPLE{"32T3K 765\n"
+                                   "T55J5 684\n"
+                                   "KK677 28\n"
+                                   "KTJJT 220\n"
+                                   "QQQJA 483\n"};
+
 void
 tests() {
-  using namespace std::literals::string_view_literals;
-  std::vector<std::string> const lines{
-      "32T3K 765",
-      "T55J5 684",
-      "KK677 28",
-      "KTJJT 220",
-      "QQQJA 483",
-  };
-  ASSERT(get_total_winnings(lines) == 5905);
+  ASSERT(get_total_winnings(split_lines(EXAMPLE)) == 5905);
 }
 
-u64
+constexpr u64
 get_total_winnings(std::vector<std::string> const &lines) {
   std::vector<Hand> hands;
   for (auto const &line : lines) {
@@ -84,7 +86,7 @@ get_total_winnings(std::vector<std::string> const &lines) {
     if (lhs.type == rhs.type) {
       for (auto const &[l, r] : std::views::zip(lhs.cards, rhs.cards)) {
         if (l != r) {
-          return CARD_VALUE.at(l) < CARD_VALUE.at(r);
+          return get_card_value(l) < get_card_value(r);
         }
       }
     }
@@ -101,57 +103,65 @@ get_total_winnings(std::vector<std::string> const &lines) {
       });
 }
 
-HandType
+constexpr u8
+get_card_value(char card) {
+  std::size_t const value = CARDS.find(card);
+  if (value == std::string_view::npos) {
+    UNREACHABLE();
+  }
+  return static_cast<u8>(value);
+}
+
+constexpr HandType
 get_hand_type(std::string_view hand) {
+  std::array<u8, CARDS.size()> counts{};
   u8 num_jokers{};
-  std::unordered_map<char, u8> counter;
   for (char c : hand) {
     if (c == 'J') {
       ++num_jokers;
       continue;
     }
-
-    auto find_it = counter.find(c);
-    if (find_it == counter.end()) {
-      counter.emplace(c, 1);
-    } else {
-      ++find_it->second;
-    }
+    ++counts[get_card_value(c)];
   }
-
-  std::vector<std::pair<char, u8>> counter_vec;
-  counter_vec.reserve(counter.size());
-  for (auto const &[k, v] : counter) {
-    counter_vec.emplace_back(k, v);
-  }
-
-  std::ranges::sort(counter_vec, [](auto const &lhs, auto const &rhs) {
-    return lhs.second > rhs.second;
-  });
+  std::ranges::sort(counts, std::ranges::greater());
 
   if (num_jokers == 5) {
     return FIVE_OF_A_KIND;
   }
 
-  counter_vec[0].second += num_jokers;
-  if (counter_vec[0].second == 5) {
+  counts[0] += num_jokers;
+
+  if (counts[0] == 5) {
     return FIVE_OF_A_KIND;
   }
-  if (counter_vec[0].second == 4) {
+  if (counts[0] == 4) {
     return FOUR_OF_A_KIND;
   }
-  if (counter_vec[0].second == 3 && counter_vec[1].second == 2) {
+  if (counts[0] == 3 && counts[1] == 2) {
     return FULL_HOUSE;
   }
-  if (counter_vec[0].second == 3 && counter_vec[1].second == 1) {
+  if (counts[0] == 3 && counts[1] == 1) {
     return THREE_OF_A_KIND;
   }
-  if (counter_vec[0].second == 2 && counter_vec[1].second == 2) {
+  if (counts[0] == 2 && counts[1] == 2) {
     return TWO_PAIR;
   }
-  if (counter_vec[0].second == 2 && counter_vec[1].second == 1) {
+  if (counts[0] == 2 && counts[1] == 1) {
     return ONE_PAIR;
   }
   return HIGH_CARD;
 }
+
+static_assert(get_total_winnings(split_lines(EXAMPLE)) == 5905);
 } // namespace
+
+#ifdef AOC_EMBED_INPUT
+#include AOC_EMBED_INPUT // EMBEDDED_INPUT
+
+int
+main(int argc, char const **argv) {
+  static constexpr u64 ANSWER = get_total_winnings(split_lines(EMBEDDED_INPUT));
+  return embedded_main(
+      argc, argv, 7, 2, std::format("{}", ANSWER), EMBEDDED_INPUT);
+}
+#endif
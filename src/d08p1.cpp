@@ -1,29 +1,71 @@
+#include "model_cache.hpp" // load_model
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
-#include <print> // std::println
-#include <regex> // std::regex
+#include <algorithm> // std::ranges::find_if
+#include <array> // std::array
+#include <format> // std::format
 #include <unordered_map> // std::unordered_map
 
-using desert_map_t =
-    std::unordered_map<std::string, std::pair<std::string, std::string>>;
-
 namespace
 {
+/// the map as it is cached (see model_cache.hpp): the nodes interned to their
+/// index in the node table, and the directions as the index of the neighbour
+/// to go to
+struct Node
+{
+  std::array<char, 4> m_name;
+  std::array<u32, 2> m_next;
+};
+
+struct MapModel
+{
+  u64 m_directions_offset;
+  u64 m_num_directions;
+  u64 m_nodes_offset;
+  u64 m_num_nodes;
+};
+
+constexpr u32 MODEL_VERSION{1};
+
 void
 tests();
 u64
 get_num_steps_to_end(std::vector<std::string> const &lines);
-std::pair<std::vector<char>, desert_map_t>
-parse_map(std::vector<std::string> const &lines);
+u64
+get_num_steps_to_end(ModelView model);
+std::string
+build_model(std::vector<std::string> const &lines);
+std::string_view
+get_name(Node const &node);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_num_steps_to_end(lines));
-  return 0;
+  return solver_main(argc, argv, 8, 1);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 8,
+     .m_part = 1,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}", get_num_steps_to_end(lines));
+         },
+     .m_solve_file = [](char const *path) -> std::optional<std::string> {
+       std::optional<Model> const model =
+           load_model(path, "d08p1", MODEL_VERSION, build_model);
+       if (!model) {
+         return std::nullopt;
+       }
+       return std::format("{}", get_num_steps_to_end(model->view()));
+     }}};
+} // namespace
 
 namespace
 {
@@ -57,36 +99,71 @@ tests() {
 
 u64
 get_num_steps_to_end(std::vector<std::string> const &lines) {
-  auto [directions, desert_map] = parse_map(lines);
+  return get_num_steps_to_end(ModelView(build_model(lines)));
+}
+
+u64
+get_num_steps_to_end(ModelView model) {
+  auto const &map = model.get<MapModel>(0);
+  auto const directions =
+      model.get_array<u8>(map.m_directions_offset, map.m_num_directions);
+  auto const nodes = model.get_array<Node>(map.m_nodes_offset, map.m_num_nodes);
+  auto const find_node = [&nodes](std::string_view name) {
+    auto find_it = std::ranges::find(nodes, name, get_name);
+    ASSERT(find_it != nodes.end());
+    return static_cast<u32>(find_it - nodes.begin());
+  };
+
   u64 num_steps{};
-  auto const dir_size{directions.size()};
-  std::string cur_state{"AAA"};
-  while (cur_state != "ZZZ") {
-    auto find_it = desert_map.find(cur_state);
-    if (directions[num_steps % dir_size] == 'L') {
-      cur_state = find_it->second.first;
-    } else {
-      cur_state = find_it->second.second;
-    }
-    ++num_steps;
+  u32 const end_node = find_node("ZZZ");
+  for (u32 node = find_node("AAA"); node != end_node; ++num_steps) {
+    node = nodes[node].m_next[directions[num_steps % directions.size()]];
   }
   return num_steps;
 }
 
-std::pair<std::vector<char>, desert_map_t>
-parse_map(std::vector<std::string> const &lines) {
-  std::vector<char> directions = lines[0] | std::ranges::to<std::vector<char>>();
-  desert_map_t desert_map;
-  std::regex const re{R"XXX((...) = \((...), (...)\))XXX"};
-  std::smatch match;
-  for (auto const &line : lines | std::views::drop(2)) {
-    if (std::regex_match(line, match, re)) {
-      auto it = match.begin();
-      desert_map.emplace(std::piecewise_construct,
-                         std::forward_as_tuple(it[1].str()),
-                         std::forward_as_tuple(it[2].str(), it[3].str()));
+std::string
+build_model(std::vector<std::string> const &lines) {
+  std::vector<u8> const directions =
+      lines[0] | std::views::transform([](char dir) { return u8(dir != 'L'); })
+      | std::ranges::to<std::vector<u8>>();
+
+  std::vector<Node> nodes;
+  std::unordered_map<std::string_view, u32> node_indices;
+  auto const intern = [&](std::string_view name) {
+    auto [it, inserted] =
+        node_indices.try_emplace(name, static_cast<u32>(nodes.size()));
+    if (inserted) {
+      Node node{};
+      name.copy(node.m_name.data(), 3);
+      nodes.emplace_back(node);
+    }
+    return it->second;
+  };
+  for (std::string_view const line : lines | std::views::drop(2)) {
+    // AAA = (BBB, CCC)
+    if (line.size() != 16) {
+      continue;
     }
+    u32 const node = intern(line.substr(0, 3));
+    u32 const left = intern(line.substr(7, 3));
+    u32 const right = intern(line.substr(12, 3));
+    nodes[node].m_next = {left, right};
   }
-  return {directions, desert_map};
+
+  ModelWriter writer;
+  u64 const root = writer.append(MapModel{});
+  writer.overwrite(root,
+                   MapModel{.m_directions_offset =
+                                writer.append_array(directions),
+                            .m_num_directions = directions.size(),
+                            .m_nodes_offset = writer.append_array(nodes),
+                            .m_num_nodes = nodes.size()});
+  return writer.release();
+}
+
+std::string_view
+get_name(Node const &node) {
+  return {node.m_name.data(), 3};
 }
 } // namespace
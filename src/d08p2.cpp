@@ -1,52 +1,52 @@
+#include "model_cache.hpp" // load_model
+#include "solver.hpp" // SolverRegistrar, solver_main
+#include "task_scheduler.hpp" // TaskGroup
 #include "utility.hpp"
 
 #include <algorithm> // std::ranges::fold_left
+#include <array> // std::array
+#include <format> // std::format
 #include <numeric> // std::lcm
-#include <print> // std::println
-#include <regex> // std::regex
 #include <unordered_map> // std::unordered_map
-#include <unordered_set> // std::unordered_set
 
-using desert_map_t =
-    std::unordered_map<std::string, std::pair<std::string, std::string>>;
-
-struct State
+namespace
+{
+/// the map as it is cached (see model_cache.hpp): the nodes interned to their
+/// index in the node table, and the directions as the index of the neighbour
+/// to go to
+struct Node
 {
-  std::string name;
-  std::size_t idx;
+  std::array<char, 4> m_name;
+  std::array<u32, 2> m_next;
 };
 
-bool
-operator==(State const &lhs, State const &rhs) {
-  return lhs.name == rhs.name && lhs.idx == rhs.idx;
-}
-
-template <>
-struct std::hash<State>
+struct MapModel
 {
-  std::size_t
-  operator()(State const &state) const noexcept {
-    std::size_t h1 = std::hash<std::string>{}(state.name);
-    std::size_t h2 = std::hash<std::size_t>{}(state.idx);
-
-    std::size_t ret_val = 0;
-    hash_combine(ret_val, h1, h2);
-    return ret_val;
-  }
+  u64 m_directions_offset;
+  u64 m_num_directions;
+  u64 m_nodes_offset;
+  u64 m_num_nodes;
 };
 
-namespace
-{
+constexpr u32 MODEL_VERSION{1};
+
 void
 tests();
 u64
 get_num_steps_to_end(std::vector<std::string> const &lines);
-std::pair<std::vector<char>, desert_map_t>
-parse_map(std::vector<std::string> const &lines);
+u64
+get_num_steps_to_end(ModelView model);
+std::string
+build_model(std::vector<std::string> const &lines);
 std::vector<std::vector<u64>>
-get_state_num_steps(std::vector<char> const &directions,
-                    desert_map_t const &desert_map,
-                    std::vector<std::string> const &states);
+get_state_num_steps(std::span<u8 const> directions,
+                    std::span<Node const> nodes,
+                    std::vector<u32> const &states,
+                    TaskScheduler &scheduler);
+std::vector<u64>
+get_num_steps_to_final_states(std::span<u8 const> directions,
+                              std::span<Node const> nodes,
+                              u32 state);
 std::vector<u64>
 collect_states(std::vector<std::size_t> const &indices,
                std::vector<std::vector<u64>> const &state_num_steps);
@@ -57,13 +57,32 @@ u64
 lcm(std::vector<u64> const &states);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_num_steps_to_end(lines));
-  return 0;
+  return solver_main(argc, argv, 8, 2);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 8,
+     .m_part = 2,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}", get_num_steps_to_end(lines));
+         },
+     .m_solve_file = [](char const *path) -> std::optional<std::string> {
+       std::optional<Model> const model =
+           load_model(path, "d08p2", MODEL_VERSION, build_model);
+       if (!model) {
+         return std::nullopt;
+       }
+       return std::format("{}", get_num_steps_to_end(model->view()));
+     }}};
+} // namespace
 
 namespace
 {
@@ -86,20 +105,24 @@ tests() {
 
 u64
 get_num_steps_to_end(std::vector<std::string> const &lines) {
-  auto [directions, desert_map] = parse_map(lines);
-  std::unordered_set<std::string> states_set;
-  std::vector<std::string> states;
-  for (auto const &[k, v] : desert_map) {
-    if (k.back() == 'A') {
-      if (!states_set.contains(k)) {
-        states.emplace_back(k);
-        states_set.insert(k);
-      }
+  return get_num_steps_to_end(ModelView(build_model(lines)));
+}
+
+u64
+get_num_steps_to_end(ModelView model) {
+  auto const &map = model.get<MapModel>(0);
+  auto const directions =
+      model.get_array<u8>(map.m_directions_offset, map.m_num_directions);
+  auto const nodes = model.get_array<Node>(map.m_nodes_offset, map.m_num_nodes);
+  std::vector<u32> states;
+  for (u32 node = 0; node < nodes.size(); ++node) {
+    if (nodes[node].m_name[2] == 'A') {
+      states.emplace_back(node);
     }
   }
 
   std::vector<std::vector<u64>> state_num_steps =
-      get_state_num_steps(directions, desert_map, states);
+      get_state_num_steps(directions, nodes, states, default_scheduler());
 
   std::vector<std::size_t> indices(state_num_steps.size());
   auto sizes = state_num_steps | std::views::transform(std::ranges::size)
@@ -116,59 +139,92 @@ get_num_steps_to_end(std::vector<std::string> const &lines) {
   return min_lcm;
 }
 
-std::pair<std::vector<char>, desert_map_t>
-parse_map(std::vector<std::string> const &lines) {
-  std::vector<char> directions = lines[0] | std::ranges::to<std::vector<char>>();
-  desert_map_t desert_map;
-  std::regex const re{R"XXX((...) = \((...), (...)\))XXX"};
-  std::smatch match;
-  for (auto const &line : lines | std::views::drop(2)) {
-    if (std::regex_match(line, match, re)) {
-      auto it = match.begin();
-      desert_map.emplace(std::piecewise_construct,
-                         std::forward_as_tuple(it[1].str()),
-                         std::forward_as_tuple(it[2].str(), it[3].str()));
+std::string
+build_model(std::vector<std::string> const &lines) {
+  std::vector<u8> const directions =
+      lines[0] | std::views::transform([](char dir) { return u8(dir != 'L'); })
+      | std::ranges::to<std::vector<u8>>();
+
+  std::vector<Node> nodes;
+  std::unordered_map<std::string_view, u32> node_indices;
+  auto const intern = [&](std::string_view name) {
+    auto [it, inserted] =
+        node_indices.try_emplace(name, static_cast<u32>(nodes.size()));
+    if (inserted) {
+      Node node{};
+      name.copy(node.m_name.data(), 3);
+      nodes.emplace_back(node);
+    }
+    return it->second;
+  };
+  for (std::string_view const line : lines | std::views::drop(2)) {
+    // 11A = (11B, XXX)
+    if (line.size() != 16) {
+      continue;
     }
+    u32 const node = intern(line.substr(0, 3));
+    u32 const left = intern(line.substr(7, 3));
+    u32 const right = intern(line.substr(12, 3));
+    nodes[node].m_next = {left, right};
   }
-  return {directions, desert_map};
+
+  ModelWriter writer;
+  u64 const root = writer.append(MapModel{});
+  writer.overwrite(root,
+                   MapModel{.m_directions_offset =
+                                writer.append_array(directions),
+                            .m_num_directions = directions.size(),
+                            .m_nodes_offset = writer.append_array(nodes),
+                            .m_num_nodes = nodes.size()});
+  return writer.release();
 }
 
+/// the ghosts' cycles differ in length by orders of magnitude, so every
+/// starting state is walked as a task of its own
 std::vector<std::vector<u64>>
-get_state_num_steps(std::vector<char> const &directions,
-                    desert_map_t const &desert_map,
-                    std::vector<std::string> const &states) {
+get_state_num_steps(std::span<u8 const> directions,
+                    std::span<Node const> nodes,
+                    std::vector<u32> const &states,
+                    TaskScheduler &scheduler) {
+  std::vector<std::vector<u64>> state_num_steps(states.size());
+  TaskGroup group(scheduler);
+  for (std::size_t idx = 0; idx < states.size(); ++idx) {
+    group.spawn([&, idx] {
+      state_num_steps[idx] =
+          get_num_steps_to_final_states(directions, nodes, states[idx]);
+    });
+  }
+  group.wait();
+  return state_num_steps;
+}
+
+std::vector<u64>
+get_num_steps_to_final_states(std::span<u8 const> directions,
+                              std::span<Node const> nodes,
+                              u32 state) {
   std::size_t const dir_size{directions.size()};
-  std::vector<std::vector<u64>> state_num_steps;
-  for (auto state : states) {
-    std::vector<u64> num_steps_vec;
-    u64 num_steps{};
-    std::unordered_set<State> visited;
-    while (true) {
-      auto find_it = desert_map.find(state);
-      std::size_t idx = num_steps % dir_size;
-      char dir = directions[idx];
-
-      if (visited.contains({state, idx})) {
-        break;
-      }
-      visited.insert({state, idx});
-
-      // if we reached a final state, mark the number of steps
-      if (state.back() == 'Z') {
-        num_steps_vec.emplace_back(num_steps);
-      }
-
-      // advance state
-      if (dir == 'L') {
-        state = find_it->second.first;
-      } else {
-        state = find_it->second.second;
-      }
-      ++num_steps;
+  std::vector<u64> num_steps_vec;
+  u64 num_steps{};
+  // indexed by (node, direction index)
+  std::vector<bool> visited(nodes.size() * dir_size);
+  while (true) {
+    std::size_t idx = num_steps % dir_size;
+    std::size_t const visited_idx = (state * dir_size) + idx;
+    if (visited[visited_idx]) {
+      break;
     }
-    state_num_steps.emplace_back(std::move(num_steps_vec));
+    visited[visited_idx] = true;
+
+    // if we reached a final state, mark the number of steps
+    if (nodes[state].m_name[2] == 'Z') {
+      num_steps_vec.emplace_back(num_steps);
+    }
+
+    // advance state
+    state = nodes[state].m_next[directions[idx]];
+    ++num_steps;
   }
-  return state_num_steps;
+  return num_steps_vec;
 }
 
 bool
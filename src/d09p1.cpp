@@ -1,86 +1,106 @@
+#include "generator.hpp" // Generator
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
-#include <algorithm> // std::ranges::all_of
-#include <print> // std::println
+#include <algorithm> // std::ranges::fold_left
+#include <format> // std::format
+#include <functional> // std::plus
 #include <ranges> // std::views::transform
-#include <stack> // std::stack
-
-using i64 = std::int64_t;
 
 namespace
 {
 void
 tests();
-i64
+constexpr i64
 get_sum_of_extrapolated_values(std::vector<std::string> const &lines);
-i64
-extrapolate_last_value(std::vector<i64> const &values);
-std::vector<i64>
-get_diffs(std::vector<i64> const &values);
-bool
-all_zeros(std::vector<i64> const &values);
+constexpr i64
+get_extrapolated_value(std::string_view line);
+constexpr i64
+extrapolate_last_value(std::ranges::input_range auto &&values);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_sum_of_extrapolated_values(lines));
-  return 0;
+  return solver_main(argc, argv, 9, 1);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 9,
+     .m_part = 1,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}", get_sum_of_extrapolated_values(lines));
+         },
+     .m_make_accumulator = [] {
+       return make_line_sum_accumulator(get_extrapolated_value);
+     }}};
+} // namespace
 
 namespace
 {
+constexpr std::string_view EXAMPLE{"0 3 6 9 12 15\n"
+                                   "1 3 6 10 15 21\n"
+                                   "10 13 16 21 30 45\n"};
+
 void
 tests() {
-  std::vector<std::string> const lines{
-      "0 3 6 9 12 15",
-      "1 3 6 10 15 21",
-      "10 13 16 21 30 45",
-  };
-  ASSERT(get_sum_of_extrapolated_values(lines) == 114);
+  ASSERT(get_sum_of_extrapolated_values(split_lines(EXAMPLE)) == 114);
 }
 
-i64
+constexpr i64
 get_sum_of_extrapolated_values(std::vector<std::string> const &lines) {
   i64 total = 0;
   for (auto const &line : lines) {
-    auto values = split(line) | std::views::transform(str_to_int<i64>)
-                  | std::ranges::to<std::vector<i64>>();
-    total += extrapolate_last_value(values);
+    total += get_extrapolated_value(line);
   }
   return total;
 }
 
-i64
-extrapolate_last_value(std::vector<i64> const &values) {
-  std::stack<std::vector<i64>> values_stack;
-  values_stack.push(values);
-
-  while (!all_zeros(values_stack.top())) {
-    values_stack.push(get_diffs(values_stack.top()));
-  }
-  while (values_stack.size() > 1) {
-    auto old_top = std::move(values_stack.top());
-    values_stack.pop();
-    std::vector<i64> &top = values_stack.top();
-    top.emplace_back(top.back() + old_top.back());
+constexpr i64
+get_extrapolated_value(std::string_view line) {
+  // a coroutine can't run in a constant expression, so the compiler parses
+  // the whole line up front instead of streaming it through the Generator
+  if consteval {
+    return extrapolate_last_value(split(line)
+                                  | std::views::transform(str_to_int<i64>));
+  } else {
+    return extrapolate_last_value(parse_ints<i64>(tokenize(line)));
   }
-  return values_stack.top().back();
 }
 
-std::vector<i64>
-get_diffs(std::vector<i64> const &values) {
-  std::vector<i64> diffs(values.size() - 1);
-  for (std::size_t idx = 0, end = values.size() - 1; idx < end; ++idx) {
-    diffs[idx] = values[idx + 1] - values[idx];
+/// Newton's forward differences, streamed: only the last value of every level
+/// of differences is kept, which a new value updates from the top level down,
+/// and the next value is the sum of them
+constexpr i64
+extrapolate_last_value(std::ranges::input_range auto &&values) {
+  std::vector<i64> last_values;
+  for (i64 value : values) {
+    for (i64 &last_value : last_values) {
+      i64 const diff = value - last_value;
+      last_value = value;
+      value = diff;
+    }
+    last_values.emplace_back(value);
   }
-  return diffs;
-}
-
-bool
-all_zeros(std::vector<i64> const &values) {
-  return std::ranges::all_of(values, [](i64 const &val) { return val == 0; });
+  return std::ranges::fold_left(last_values, i64{0}, std::plus<>());
 }
 
+static_assert(get_sum_of_extrapolated_values(split_lines(EXAMPLE)) == 114);
 } // namespace
+
+#ifdef AOC_EMBED_INPUT
+#include AOC_EMBED_INPUT // EMBEDDED_INPUT
+
+int
+main(int argc, char const **argv) {
+  static constexpr i64 ANSWER =
+      get_sum_of_extrapolated_values(split_lines(EMBEDDED_INPUT));
+  return embedded_main(
+      argc, argv, 9, 1, std::format("{}", ANSWER), EMBEDDED_INPUT);
+}
+#endif
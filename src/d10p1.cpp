@@ -1,7 +1,8 @@
 #include "matrix.hpp"
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
-#include <print> // std::println
+#include <format> // std::format
 #include <ranges>
 #include <unordered_set> // std::unordered_set
 
@@ -23,13 +24,23 @@ bool
 is_transition_valid(Map const &map, Location const &src, Location const &dst);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_num_steps_to_farthest_pipe(lines));
-  return 0;
+  return solver_main(argc, argv, 10, 1);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 10,
+     .m_part = 1,
+     .m_tests = tests,
+     .m_solve = [](std::vector<std::string> const &lines) {
+       return std::format("{}", get_num_steps_to_farthest_pipe(lines));
+     }}};
+} // namespace
 
 namespace
 {
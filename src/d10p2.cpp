@@ -1,7 +1,13 @@
 #include "matrix.hpp"
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
-#include <print> // std::println
+#include <algorithm> // std::ranges::count_if
+#include <array> // std::array
+#include <cmath> // std::sqrt
+#include <format> // std::format
+#include <optional> // std::optional
+#include <random> // std::mt19937_64
 #include <ranges>
 #include <unordered_set> // std::unordered_set
 
@@ -27,17 +33,38 @@ Dir
 get_direction(Location const &src, Location const &dst);
 void
 mark_by_ray_tracing(Map &map);
-void
-print_map(Map const &map);
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size);
+bool
+can_add_square(std::vector<bool> const &region,
+                std::size_t size,
+                Location const &square);
+std::vector<Location>
+get_boundary(std::vector<bool> const &region, std::size_t size);
+char
+get_pipe(Location const &prev, Location const &loc, Location const &next);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_num_tiles_inside_loop(lines));
-  return 0;
+  return solver_main(argc, argv, 10, 2);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 10,
+     .m_part = 2,
+     .m_tests = tests,
+     .m_solve =
+         [](std::vector<std::string> const &lines) {
+           return std::format("{}", get_num_tiles_inside_loop(lines));
+         },
+     .m_generate = generate_input,
+     .m_complexity = Complexity::LINEAR}};
+} // namespace
 
 namespace
 {
@@ -115,7 +142,6 @@ get_num_tiles_inside_loop(std::vector<std::string> const &lines) {
   update_map_start(clean_map, loop_path);
 
   mark_by_ray_tracing(clean_map);
-  print_map(clean_map);
 
   u64 num_tiles{};
   for (u64 row = 0; row < clean_map.rows(); ++row) {
@@ -259,6 +285,11 @@ update_map_start(Map &map, std::vector<Location> const &loop) {
     map(strt.row, strt.col) = 'L';
     return;
   }
+  if (dirs.first == dirs.second) {
+    bool const is_vertical = dirs.first == Dir::UP || dirs.first == Dir::DOWN;
+    map(strt.row, strt.col) = is_vertical ? '|' : '-';
+    return;
+  }
   UNREACHABLE();
 }
 
@@ -315,25 +346,203 @@ mark_by_ray_tracing(Map &map) {
   }
 }
 
-void
-print_map(Map const &map) {
-  for (std::size_t row = 0; row < map.rows(); ++row) {
-    bool all_dot = true;
-    for (u64 col = 0; col < map.cols(); ++col) {
-      if (map(row, col) != '.') {
-        all_dot = false;
-        break;
-      }
-    }
-    if (all_dot) {
+/// a loop around a random region of about `size` squares with no holes, whose
+/// boundary goes through the tiles, among junk pipes
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size) {
+  // the squares of the region, on a grid of grid_size x grid_size squares
+  auto const grid_size =
+      (2 * static_cast<std::size_t>(std::sqrt(static_cast<double>(size)))) + 2;
+  auto random = [&rng](std::size_t high) {
+    return std::uniform_int_distribution<std::size_t>(0, high - 1)(rng);
+  };
+  std::vector<bool> region(grid_size * grid_size, false);
+  std::vector<std::size_t> squares{
+      ((grid_size / 2) * grid_size) + (grid_size / 2)};
+  region[squares[0]] = true;
+  for (std::size_t attempt = 0; attempt < 20 * size && squares.size() < size;
+       ++attempt) {
+    std::size_t const square = squares[random(squares.size())];
+    std::size_t const row = square / grid_size;
+    std::size_t const col = square % grid_size;
+    std::array const neighbors{Location{.row = row - 1, .col = col},
+                               Location{.row = row + 1, .col = col},
+                               Location{.row = row, .col = col - 1},
+                               Location{.row = row, .col = col + 1}};
+    // a row or column of -1 wraps around to a huge one
+    Location const neighbor = neighbors[random(neighbors.size())];
+    if (neighbor.row >= grid_size || neighbor.col >= grid_size
+        || region[(neighbor.row * grid_size) + neighbor.col]
+        || !can_add_square(region, grid_size, neighbor)) {
       continue;
     }
-    for (std::size_t col = 0; col < map.cols(); ++col) {
-      std::print("{}", map(row, col));
+    std::size_t const new_square = (neighbor.row * grid_size) + neighbor.col;
+    region[new_square] = true;
+    squares.emplace_back(new_square);
+  }
+
+  // the corners of the squares are the tiles, with a margin of junk around
+  std::vector<Location> const boundary = get_boundary(region, grid_size);
+  // can_add_square() only lets the region grow while its boundary stays a
+  // single loop, and a single square is bounded by one
+  ASSERT(!boundary.empty());
+  std::size_t const num_tiles = grid_size + 3;
+  static constexpr std::string_view JUNK{"....|-LJ7F"};
+  std::vector<std::string> lines(num_tiles, std::string(num_tiles, '.'));
+  for (std::string &line : lines) {
+    for (char &tile : line) {
+      tile = JUNK[random(JUNK.size())];
+    }
+  }
+  for (std::size_t idx = 0; idx < boundary.size(); ++idx) {
+    Location const &prev =
+        boundary[(idx + boundary.size() - 1) % boundary.size()];
+    Location const &next = boundary[(idx + 1) % boundary.size()];
+    lines[boundary[idx].row + 1][boundary[idx].col + 1] =
+        get_pipe(prev, boundary[idx], next);
+  }
+  Location const start = boundary[random(boundary.size())];
+  lines[start.row + 1][start.col + 1] = 'S';
+  // no junk pipe may seem to connect to the start
+  for (Location const tile :
+       {Location{.row = start.row, .col = start.col + 1},
+        Location{.row = start.row + 2, .col = start.col + 1},
+        Location{.row = start.row + 1, .col = start.col},
+        Location{.row = start.row + 1, .col = start.col + 2}}) {
+    Location const corner{.row = tile.row - 1, .col = tile.col - 1};
+    if (std::ranges::find(boundary, corner) == boundary.end()) {
+      lines[tile.row][tile.col] = '.';
+    }
+  }
+  return lines;
+}
+
+/// whether the boundary of the region stays a single loop that never touches
+/// itself with the square added to it, which only depends on the squares
+/// around it: those in the region must be a single run around the square, and
+/// none of them may only touch it at a corner
+bool
+can_add_square(std::vector<bool> const &region,
+               std::size_t size,
+               Location const &square) {
+  auto is_in = [&](std::size_t row, std::size_t col) {
+    // a row or column of -1 wraps around to a huge one
+    return row < size && col < size && region[(row * size) + col];
+  };
+  std::size_t const row = square.row;
+  std::size_t const col = square.col;
+  // clockwise from the top left one; the odd ones share an edge with it
+  std::array const around{is_in(row - 1, col - 1),
+                          is_in(row - 1, col),
+                          is_in(row - 1, col + 1),
+                          is_in(row, col + 1),
+                          is_in(row + 1, col + 1),
+                          is_in(row + 1, col),
+                          is_in(row + 1, col - 1),
+                          is_in(row, col - 1)};
+  std::size_t num_runs{};
+  for (std::size_t idx = 0; idx < around.size(); ++idx) {
+    bool const prev = around[(idx + around.size() - 1) % around.size()];
+    bool const next = around[(idx + 1) % around.size()];
+    if (idx % 2 == 0 && around[idx] && !prev && !next) {
+      return false;
+    }
+    if (around[idx] && !prev) {
+      ++num_runs;
+    }
+  }
+  // two runs would enclose the squares between them in a hole
+  return num_runs == 1;
+}
+
+/// the corners on the boundary of the region of squares, in order around it;
+/// empty unless the boundary is a single loop that never touches itself
+std::vector<Location>
+get_boundary(std::vector<bool> const &region, std::size_t size) {
+  auto is_in = [&](std::size_t row, std::size_t col) {
+    // a row or column of -1 wraps around to a huge one
+    return row < size && col < size && region[(row * size) + col];
+  };
+  // the corner (row, col) is the top left one of the square (row, col); an
+  // edge is on the boundary when exactly one of the squares along it is in
+  auto is_boundary = [&](Location const &src, Dir dir) {
+    switch (dir) {
+    case Dir::UP:
+      return is_in(src.row - 1, src.col - 1) != is_in(src.row - 1, src.col);
+    case Dir::DOWN:
+      return is_in(src.row, src.col - 1) != is_in(src.row, src.col);
+    case Dir::LEFT:
+      return is_in(src.row - 1, src.col - 1) != is_in(src.row, src.col - 1);
+    case Dir::RIGHT:
+      return is_in(src.row - 1, src.col) != is_in(src.row, src.col);
+    }
+    UNREACHABLE();
+  };
+  auto step = [](Location const &src, Dir dir) {
+    switch (dir) {
+    case Dir::UP:
+      return Location{.row = src.row - 1, .col = src.col};
+    case Dir::DOWN:
+      return Location{.row = src.row + 1, .col = src.col};
+    case Dir::LEFT:
+      return Location{.row = src.row, .col = src.col - 1};
+    case Dir::RIGHT:
+      return Location{.row = src.row, .col = src.col + 1};
+    }
+    UNREACHABLE();
+  };
+
+  std::size_t num_edges{};
+  std::optional<Location> first;
+  for (std::size_t row = 0; row <= size; ++row) {
+    for (std::size_t col = 0; col <= size; ++col) {
+      Location const corner{.row = row, .col = col};
+      auto const degree = std::ranges::count_if(
+          ALL_DIRS, [&](Dir dir) { return is_boundary(corner, dir); });
+      if (degree > 2) {
+        // the loop would touch itself here
+        return {};
+      }
+      num_edges += static_cast<std::size_t>(degree);
+      if (degree != 0 && !first) {
+        first = corner;
+      }
     }
-    std::println();
   }
-  std::println();
+
+  std::vector<Location> boundary{*first};
+  std::optional<Location> prev;
+  do {
+    Location const loc = boundary.back();
+    for (Dir const dir : ALL_DIRS) {
+      Location const next = step(loc, dir);
+      if (is_boundary(loc, dir) && next != prev) {
+        boundary.emplace_back(next);
+        break;
+      }
+    }
+    prev = loc;
+  } while (boundary.back() != boundary.front());
+  boundary.pop_back();
+  // every edge is counted from both its ends; more edges than the loop has
+  // means there's a second loop, around a hole
+  return boundary.size() * 2 == num_edges ? boundary : std::vector<Location>{};
 }
 
+char
+get_pipe(Location const &prev, Location const &loc, Location const &next) {
+  Dir const from = get_direction(loc, prev);
+  Dir const to = get_direction(loc, next);
+  auto connects = [&](Dir dir) { return from == dir || to == dir; };
+  if (connects(Dir::UP)) {
+    if (connects(Dir::DOWN)) {
+      return '|';
+    }
+    return connects(Dir::LEFT) ? 'J' : 'L';
+  }
+  if (connects(Dir::DOWN)) {
+    return connects(Dir::LEFT) ? '7' : 'F';
+  }
+  return '-';
+}
 } // namespace
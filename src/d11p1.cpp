@@ -1,7 +1,11 @@
 #include "matrix.hpp" // Matrix
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
+#include <cmath> // std::sqrt
+#include <format> // std::format
 #include <print> // std::println
+#include <random> // std::mt19937_64
 #include <vector> // std::vector
 
 using Map = Matrix<char>;
@@ -22,17 +26,31 @@ std::vector<u64>
 get_empty_cols(Map const &map);
 std::vector<Location>
 get_galaxy_locs(Map const &aug_map);
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size);
 void
 print_map(Map const &map);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_sum_of_shortest_path_lengths(lines));
-  return 0;
+  return solver_main(argc, argv, 11, 1);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 11,
+     .m_part = 1,
+     .m_tests = tests,
+     .m_solve = [](std::vector<std::string> const &lines) {
+       return std::format("{}", get_sum_of_shortest_path_lengths(lines));
+     },
+     .m_generate = generate_input,
+     .m_complexity = Complexity::N_LOG_N}};
+} // namespace
 
 namespace
 {
@@ -206,4 +224,32 @@ print_map(Map const &map) {
   }
   std::println();
 }
+
+/// about `size` galaxies, in an image about twice the square root of that wide
+/// and high, with about an eighth of its rows and columns empty
+std::vector<std::string>
+generate_input(std::mt19937_64 &rng, std::size_t size) {
+  auto const side =
+      (2 * static_cast<std::size_t>(std::sqrt(static_cast<double>(size)))) + 2;
+  std::bernoulli_distribution is_empty(1.0 / 8);
+  std::vector<std::size_t> rows{0};
+  std::vector<std::size_t> cols{0};
+  for (std::size_t idx = 1; idx < side; ++idx) {
+    if (!is_empty(rng)) {
+      rows.emplace_back(idx);
+    }
+    if (!is_empty(rng)) {
+      cols.emplace_back(idx);
+    }
+  }
+  auto random = [&rng](std::vector<std::size_t> const &values) {
+    return values[std::uniform_int_distribution<std::size_t>(
+        0, values.size() - 1)(rng)];
+  };
+  std::vector<std::string> lines(side, std::string(side, '.'));
+  for (std::size_t idx = 0; idx < size; ++idx) {
+    lines[random(rows)][random(cols)] = '#';
+  }
+  return lines;
+}
 } // namespace
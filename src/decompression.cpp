@@ -0,0 +1,374 @@
+#include "decompression.hpp"
+
+#include <algorithm> // std::max
+#include <array> // std::array
+#include <cerrno> // errno
+#include <fcntl.h> // open
+#include <libassert/assert.hpp> // UNREACHABLE
+#include <memory> // std::unique_ptr
+#include <unistd.h> // read
+
+#ifdef AOC_HAVE_ZLIB
+#include <zlib.h> // inflate
+#endif
+#ifdef AOC_HAVE_ZSTD
+#include <zstd.h> // ZSTD_decompressStream
+#endif
+
+namespace
+{
+constexpr std::string_view GZIP_MAGIC{"\x1f\x8b"};
+constexpr std::string_view ZSTD_MAGIC{"\x28\xb5\x2f\xfd"};
+constexpr std::size_t INPUT_SIZE{64 * 1024};
+
+/// One of the streaming decoders.
+class Decoder
+{
+public:
+  Decoder() = default;
+  Decoder(Decoder const &) = delete;
+  Decoder(Decoder &&) = delete;
+  Decoder &
+  operator=(Decoder const &) = delete;
+  Decoder &
+  operator=(Decoder &&) = delete;
+  virtual ~Decoder() = default;
+
+  /// decode the start of `input`, removing what was consumed, and append at
+  /// most `max_size` bytes to `output`; false on corrupt input
+  virtual bool
+  decode(std::string_view &input,
+         std::string &output,
+         std::size_t max_size) = 0;
+
+  /// whether the input so far ends at the end of a frame, i.e. isn't truncated
+  [[nodiscard]] virtual bool
+  at_frame_end() const = 0;
+};
+
+#ifdef AOC_HAVE_ZLIB
+class GzipDecoder final : public Decoder
+{
+public:
+  GzipDecoder() {
+    // 15 for the largest window, + 16 for a gzip header
+    m_ok = inflateInit2(&m_stream, 15 + 16) == Z_OK;
+  }
+  GzipDecoder(GzipDecoder const &) = delete;
+  GzipDecoder(GzipDecoder &&) = delete;
+  GzipDecoder &
+  operator=(GzipDecoder const &) = delete;
+  GzipDecoder &
+  operator=(GzipDecoder &&) = delete;
+  ~GzipDecoder() override {
+    if (m_ok) {
+      inflateEnd(&m_stream);
+    }
+  }
+
+  bool
+  decode(std::string_view &input,
+         std::string &output,
+         std::size_t max_size) override {
+    if (!m_ok) {
+      return false;
+    }
+    std::size_t const old_size = output.size();
+    output.resize(old_size + max_size);
+    // zlib never writes through next_in
+    m_stream.next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+    m_stream.avail_in = static_cast<uInt>(input.size());
+    m_stream.next_out = reinterpret_cast<Bytef *>(output.data() + old_size);
+    m_stream.avail_out = static_cast<uInt>(max_size);
+
+    bool ok = true;
+    while (m_stream.avail_out > 0 && (m_stream.avail_in > 0 || !m_at_end)) {
+      if (m_at_end) {
+        // concatenated files are one stream, like gzip -d reads them
+        inflateReset(&m_stream);
+        m_at_end = false;
+      }
+      int const ret = inflate(&m_stream, Z_NO_FLUSH);
+      if (ret == Z_STREAM_END) {
+        m_at_end = true;
+      } else if (ret == Z_BUF_ERROR) {
+        // needs more input
+        break;
+      } else if (ret != Z_OK) {
+        ok = false;
+        break;
+      }
+    }
+    input.remove_prefix(input.size() - m_stream.avail_in);
+    output.resize(old_size + max_size - m_stream.avail_out);
+    return ok;
+  }
+
+  [[nodiscard]] bool
+  at_frame_end() const override {
+    return m_at_end;
+  }
+
+private:
+  z_stream m_stream{};
+  bool m_ok;
+  bool m_at_end{false};
+};
+#endif
+
+#ifdef AOC_HAVE_ZSTD
+class ZstdDecoder final : public Decoder
+{
+public:
+  ZstdDecoder() : m_stream(ZSTD_createDStream()) {}
+  ZstdDecoder(ZstdDecoder const &) = delete;
+  ZstdDecoder(ZstdDecoder &&) = delete;
+  ZstdDecoder &
+  operator=(ZstdDecoder const &) = delete;
+  ZstdDecoder &
+  operator=(ZstdDecoder &&) = delete;
+  ~ZstdDecoder() override {
+    ZSTD_freeDStream(m_stream);
+  }
+
+  bool
+  decode(std::string_view &input,
+         std::string &output,
+         std::size_t max_size) override {
+    if (m_stream == nullptr) {
+      return false;
+    }
+    std::size_t const old_size = output.size();
+    output.resize(old_size + max_size);
+    ZSTD_inBuffer in{.src = input.data(), .size = input.size(), .pos = 0};
+    ZSTD_outBuffer out{
+        .dst = output.data() + old_size, .size = max_size, .pos = 0};
+
+    bool ok = true;
+    while (out.pos < out.size) {
+      std::size_t const old_in_pos = in.pos;
+      std::size_t const old_out_pos = out.pos;
+      std::size_t const ret = ZSTD_decompressStream(m_stream, &out, &in);
+      if (ZSTD_isError(ret) != 0) {
+        ok = false;
+        break;
+      }
+      // 0 once a frame is fully decoded and flushed; a call that does nothing
+      // past the end of a frame asks for the next one's header instead
+      if (in.pos != old_in_pos || out.pos != old_out_pos) {
+        m_at_end = ret == 0;
+      }
+      if (in.pos == in.size && out.pos < out.size) {
+        // everything that can be decoded without more input was flushed
+        break;
+      }
+    }
+    input.remove_prefix(in.pos);
+    output.resize(old_size + out.pos);
+    return ok;
+  }
+
+  [[nodiscard]] bool
+  at_frame_end() const override {
+    return m_at_end;
+  }
+
+private:
+  ZSTD_DStream *m_stream;
+  bool m_at_end{false};
+};
+#endif
+
+/// nullptr when the compression isn't supported
+std::unique_ptr<Decoder>
+make_decoder(Compression compression);
+} // namespace
+
+Compression
+detect_compression(std::string_view head) {
+  if (head.starts_with(GZIP_MAGIC)) {
+    return Compression::GZIP;
+  }
+  if (head.starts_with(ZSTD_MAGIC)) {
+    return Compression::ZSTD;
+  }
+  return Compression::NONE;
+}
+
+Compression
+detect_file_compression(char const *path) {
+  int const fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return Compression::NONE;
+  }
+  std::array<char, ZSTD_MAGIC.size()> head{};
+  ssize_t const num_read = read(fd, head.data(), head.size());
+  close(fd);
+  if (num_read <= 0) {
+    return Compression::NONE;
+  }
+  return detect_compression({head.data(), static_cast<std::size_t>(num_read)});
+}
+
+std::string_view
+get_compression_name(Compression compression) {
+  switch (compression) {
+  case Compression::NONE:
+    return "none";
+  case Compression::GZIP:
+    return "gzip";
+  case Compression::ZSTD:
+    return "zstd";
+  }
+  UNREACHABLE();
+}
+
+bool
+decompress(std::string_view compressed,
+           Compression compression,
+           std::string &contents) {
+  std::unique_ptr<Decoder> decoder = make_decoder(compression);
+  if (!decoder) {
+    return false;
+  }
+  for (;;) {
+    std::size_t const old_size = contents.size();
+    std::size_t const old_input_size = compressed.size();
+    // doubling the room every time, like push_back would
+    if (!decoder->decode(
+            compressed, contents, std::max(contents.size(), INPUT_SIZE))) {
+      return false;
+    }
+    if (contents.size() == old_size && compressed.size() == old_input_size) {
+      // no progress: the input is used up, or truncated
+      return compressed.empty() && decoder->at_frame_end();
+    }
+  }
+}
+
+DecompressionStream::DecompressionStream(char const *path,
+                                         Compression compression)
+    : m_thread([this, path = std::string(path), compression](
+                   std::stop_token const &stop_token) {
+        decode(stop_token, path, compression);
+      }) {}
+
+DecompressionStream::~DecompressionStream() {
+  m_thread.request_stop();
+}
+
+bool
+DecompressionStream::next(std::string &chunk) {
+  std::unique_lock lock(m_mutex);
+  m_cv.wait(lock, [this] { return !m_chunks.empty() || m_done; });
+  if (m_chunks.empty()) {
+    return false;
+  }
+  chunk = std::move(m_chunks.front());
+  m_chunks.pop_front();
+  lock.unlock();
+  m_cv.notify_all();
+  return true;
+}
+
+bool
+DecompressionStream::ok() const {
+  return m_ok;
+}
+
+void
+DecompressionStream::decode(std::stop_token const &stop_token,
+                            std::string const &path,
+                            Compression compression) {
+  std::unique_ptr<Decoder> decoder = make_decoder(compression);
+  int const fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  bool ok = decoder && fd != -1;
+
+  std::string input(INPUT_SIZE, '\0');
+  std::string_view pending;
+  bool at_eof = false;
+  while (ok) {
+    if (pending.empty() && !at_eof) {
+      ssize_t const num_read = read(fd, input.data(), input.size());
+      if (num_read == -1 && errno == EINTR) {
+        continue;
+      }
+      if (num_read == -1) {
+        ok = false;
+        break;
+      }
+      at_eof = num_read == 0;
+      pending = {input.data(), static_cast<std::size_t>(num_read)};
+    }
+
+    std::string chunk;
+    std::size_t const old_pending_size = pending.size();
+    if (!decoder->decode(pending, chunk, CHUNK_SIZE)) {
+      ok = false;
+      break;
+    }
+    if (!chunk.empty()) {
+      if (!push(stop_token, std::move(chunk))) {
+        break;
+      }
+    } else if (pending.empty() && at_eof) {
+      // a stream cut short mid-frame is an error, not a short input
+      ok = decoder->at_frame_end();
+      break;
+    } else if (!pending.empty() && pending.size() == old_pending_size) {
+      // no progress on the input it has
+      ok = false;
+      break;
+    }
+  }
+  if (fd != -1) {
+    close(fd);
+  }
+
+  {
+    std::lock_guard const lock(m_mutex);
+    m_done = true;
+    m_ok = ok;
+  }
+  m_cv.notify_all();
+}
+
+bool
+DecompressionStream::push(std::stop_token const &stop_token,
+                          std::string chunk) {
+  std::unique_lock lock(m_mutex);
+  if (!m_cv.wait(lock, stop_token, [this] {
+        return m_chunks.size() < MAX_AHEAD;
+      })) {
+    return false;
+  }
+  m_chunks.emplace_back(std::move(chunk));
+  lock.unlock();
+  m_cv.notify_all();
+  return true;
+}
+
+namespace
+{
+std::unique_ptr<Decoder>
+make_decoder(Compression compression) {
+  switch (compression) {
+  case Compression::NONE:
+    return nullptr;
+  case Compression::GZIP:
+#ifdef AOC_HAVE_ZLIB
+    return std::make_unique<GzipDecoder>();
+#else
+    return nullptr;
+#endif
+  case Compression::ZSTD:
+#ifdef AOC_HAVE_ZSTD
+    return std::make_unique<ZstdDecoder>();
+#else
+    return nullptr;
+#endif
+  }
+  UNREACHABLE();
+}
+} // namespace
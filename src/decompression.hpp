@@ -0,0 +1,89 @@
+#ifndef DECOMPRESSION_HPP
+#define DECOMPRESSION_HPP
+
+#include <condition_variable> // std::condition_variable_any
+#include <cstdint> // std::uint8_t
+#include <deque> // std::deque
+#include <mutex> // std::mutex
+#include <stop_token> // std::stop_token
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <thread> // std::jthread
+
+/// Transparent decompression of the inputs: a file starting with the gzip or
+/// the zstd magic bytes is read as its decompressed contents. Either format is
+/// only supported when the library it needs was found at build time.
+
+enum class Compression : std::uint8_t
+{
+  NONE,
+  GZIP,
+  ZSTD
+};
+
+/// the compression of a file starting with `head`, by its magic bytes
+Compression
+detect_compression(std::string_view head);
+
+/// the compression of the file at `path`; NONE if it can't be read
+Compression
+detect_file_compression(char const *path);
+
+std::string_view
+get_compression_name(Compression compression);
+
+/// decompress a whole buffer, appending to `contents`; false on a corrupt or
+/// truncated buffer, or a compression that isn't supported
+bool
+decompress(std::string_view compressed,
+           Compression compression,
+           std::string &contents);
+
+/// Streams the decompressed contents of a compressed file in chunks. A thread
+/// of its own reads and decodes the file ahead of the consumer, by at most
+/// MAX_AHEAD chunks, so that decoding overlaps whatever the consumer does with
+/// the chunks, in memory bounded whatever the size of the file.
+class DecompressionStream
+{
+public:
+  DecompressionStream(char const *path, Compression compression);
+  DecompressionStream(DecompressionStream const &) = delete;
+  DecompressionStream(DecompressionStream &&) = delete;
+  DecompressionStream &
+  operator=(DecompressionStream const &) = delete;
+  DecompressionStream &
+  operator=(DecompressionStream &&) = delete;
+  /// stops the decoding thread, if the stream wasn't consumed to the end
+  ~DecompressionStream();
+
+  /// move the next chunk into `chunk`; false at the end of the stream
+  bool
+  next(std::string &chunk);
+
+  /// whether the whole file was read and decoded; only meaningful once next()
+  /// returned false
+  [[nodiscard]] bool
+  ok() const;
+
+private:
+  static constexpr std::size_t CHUNK_SIZE{256 * 1024};
+  static constexpr std::size_t MAX_AHEAD{4};
+
+  std::mutex m_mutex;
+  std::condition_variable_any m_cv;
+  std::deque<std::string> m_chunks;
+  bool m_done{false};
+  bool m_ok{false};
+  // last, so that it's joined before the members it uses are destroyed
+  std::jthread m_thread;
+
+  void
+  decode(std::stop_token const &stop_token,
+         std::string const &path,
+         Compression compression);
+  /// false once the consumer is gone
+  bool
+  push(std::stop_token const &stop_token, std::string chunk);
+};
+
+#endif // DECOMPRESSION_HPP
@@ -0,0 +1,170 @@
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include "utility.hpp" // str_to_int
+
+#include <coroutine> // std::coroutine_handle
+#include <cstddef> // std::ptrdiff_t
+#include <exception> // std::exception_ptr
+#include <iterator> // std::default_sentinel_t
+#include <ranges> // std::ranges::input_range
+#include <span> // std::span
+#include <string_view> // std::string_view
+#include <utility> // std::exchange
+
+/// A lazy sequence produced by a coroutine that co_yields its values one at a
+/// time, resumed only when the next value is asked for. Generators taking a
+/// generator by value chain into a pipeline in which every value flows through
+/// all the stages before the next one is produced, so no stage materializes
+/// its whole output. An input range, usable with range-for and the ranges
+/// algorithms; being single pass, it can't be iterated twice.
+template <typename T>
+class Generator
+{
+public:
+  struct promise_type
+  {
+    T m_value{};
+    std::exception_ptr m_exception;
+
+    Generator
+    get_return_object() {
+      return Generator(handle_t::from_promise(*this));
+    }
+    std::suspend_always
+    initial_suspend() noexcept {
+      return {};
+    }
+    std::suspend_always
+    final_suspend() noexcept {
+      return {};
+    }
+    std::suspend_always
+    yield_value(T value) noexcept {
+      m_value = std::move(value);
+      return {};
+    }
+    void
+    return_void() noexcept {}
+    void
+    unhandled_exception() noexcept {
+      m_exception = std::current_exception();
+    }
+  };
+
+  class Iterator
+  {
+  public:
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+    explicit Iterator(std::coroutine_handle<promise_type> coroutine)
+        : m_coroutine(coroutine) {}
+
+    T const &
+    operator*() const {
+      return m_coroutine.promise().m_value;
+    }
+    Iterator &
+    operator++() {
+      resume(m_coroutine);
+      return *this;
+    }
+    void
+    operator++(int) {
+      ++*this;
+    }
+    bool
+    operator==(std::default_sentinel_t /*end*/) const {
+      return m_coroutine.done();
+    }
+
+  private:
+    std::coroutine_handle<promise_type> m_coroutine;
+  };
+
+  Generator(Generator const &) = delete;
+  Generator(Generator &&other) noexcept
+      : m_coroutine(std::exchange(other.m_coroutine, {})) {}
+  Generator &
+  operator=(Generator const &) = delete;
+  Generator &
+  operator=(Generator &&other) noexcept {
+    if (this != &other) {
+      if (m_coroutine) {
+        m_coroutine.destroy();
+      }
+      m_coroutine = std::exchange(other.m_coroutine, {});
+    }
+    return *this;
+  }
+  ~Generator() {
+    if (m_coroutine) {
+      m_coroutine.destroy();
+    }
+  }
+
+  Iterator
+  begin() {
+    resume(m_coroutine);
+    return Iterator(m_coroutine);
+  }
+  std::default_sentinel_t
+  end() const {
+    return {};
+  }
+
+private:
+  using handle_t = std::coroutine_handle<promise_type>;
+
+  handle_t m_coroutine;
+
+  explicit Generator(handle_t coroutine) : m_coroutine(coroutine) {}
+
+  static void
+  resume(handle_t coroutine) {
+    coroutine.resume();
+    if (coroutine.promise().m_exception) {
+      std::rethrow_exception(coroutine.promise().m_exception);
+    }
+  }
+};
+
+static_assert(std::ranges::input_range<Generator<int>>);
+
+/// the read stage: the values of a container, which must outlive the
+/// pipeline
+template <typename T>
+Generator<T>
+from_range(std::span<T const> values) {
+  for (T const &value : values) {
+    co_yield value;
+  }
+}
+
+/// the tokenize stage: split() one token at a time
+inline Generator<std::string_view>
+tokenize(std::string_view sv, std::string_view delim = " ") {
+  for (std::size_t right = sv.find(delim); right != std::string_view::npos;
+       right = sv.find(delim)) {
+    if (right != 0) {
+      co_yield sv.substr(0, right);
+    }
+    sv.remove_prefix(right + delim.size());
+  }
+  if (!sv.empty()) {
+    co_yield sv;
+  }
+}
+
+/// the parse stage
+template <typename T>
+Generator<T>
+parse_ints(Generator<std::string_view> tokens) {
+  for (std::string_view const token : tokens) {
+    co_yield str_to_int<T>(token);
+  }
+}
+
+#endif // GENERATOR_HPP
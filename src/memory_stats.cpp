@@ -0,0 +1,137 @@
+#include "memory_stats.hpp"
+
+#include <algorithm> // std::ranges::all_of
+#include <chrono> // std::chrono::milliseconds
+#include <condition_variable> // std::condition_variable_any
+#include <cstdlib> // std::abort
+#include <fstream> // std::ifstream
+#include <mutex> // std::mutex
+#include <print> // std::println
+#include <stop_token> // std::stop_token
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <sys/resource.h> // getrusage
+#include <thread> // std::jthread
+
+namespace
+{
+/// how often the watchdog looks at the peak RSS; as it's the peak, whatever
+/// is allocated and freed in between is caught all the same
+constexpr std::chrono::milliseconds WATCHDOG_PERIOD{10};
+
+/// the value of a "Name:   1234 kB" line of /proc/self/status
+u64
+parse_status_kib(std::string_view line);
+void
+watch_memory(std::stop_token const &stop_token, u64 limit_kib);
+double
+to_mib(u64 kib);
+} // namespace
+
+MemoryStats
+get_memory_stats() {
+  MemoryStats stats{};
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    // in KiB on Linux
+    stats.m_peak_rss_kib = static_cast<u64>(usage.ru_maxrss);
+    stats.m_minor_faults = static_cast<u64>(usage.ru_minflt);
+    stats.m_major_faults = static_cast<u64>(usage.ru_majflt);
+  }
+  std::ifstream status("/proc/self/status");
+  for (std::string line; std::getline(status, line);) {
+    std::string_view const sv{line};
+    if (sv.starts_with("VmHWM:")) {
+      // unlike ru_maxrss, reset by reset_peak_rss()
+      stats.m_peak_rss_kib = parse_status_kib(sv);
+    } else if (sv.starts_with("VmRSS:")) {
+      stats.m_rss_kib = parse_status_kib(sv);
+    } else if (sv.starts_with("VmSize:")) {
+      stats.m_mapped_kib = parse_status_kib(sv);
+    } else if (sv.starts_with("VmPeak:")) {
+      stats.m_peak_mapped_kib = parse_status_kib(sv);
+    }
+  }
+  return stats;
+}
+
+void
+print_memory_stats(std::FILE *stream) {
+  MemoryStats const stats = get_memory_stats();
+  std::println(stream,
+               "memory: {:.1f} MiB peak rss, {:.1f} MiB rss, {:.1f} MiB "
+               "mapped ({:.1f} MiB peak), {} minor and {} major page faults",
+               to_mib(stats.m_peak_rss_kib),
+               to_mib(stats.m_rss_kib),
+               to_mib(stats.m_mapped_kib),
+               to_mib(stats.m_peak_mapped_kib),
+               stats.m_minor_faults,
+               stats.m_major_faults);
+}
+
+bool
+reset_peak_rss() {
+  // see proc(5): 5 resets VmHWM to the current RSS
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+  clear_refs.flush();
+  return clear_refs.good();
+}
+
+void
+start_memory_watchdog() {
+  static std::jthread const watchdog = []() {
+    char const *env = std::getenv("AOC_MEMORY_LIMIT_MB");
+    if (env == nullptr) {
+      return std::jthread();
+    }
+    std::string_view const sv{env};
+    if (sv.empty() || !std::ranges::all_of(sv, is_digit)) {
+      return std::jthread();
+    }
+    u64 const limit_kib = str_to_int<u64>(sv) * 1024;
+    return std::jthread([limit_kib](std::stop_token const &stop_token) {
+      watch_memory(stop_token, limit_kib);
+    });
+  }();
+}
+
+namespace
+{
+u64
+parse_status_kib(std::string_view line) {
+  std::size_t const beg = line.find_first_of("0123456789");
+  if (beg == std::string_view::npos) {
+    return 0;
+  }
+  line.remove_prefix(beg);
+  return str_to_int<u64>(line.substr(0, line.find(' ')));
+}
+
+void
+watch_memory(std::stop_token const &stop_token, u64 limit_kib) {
+  std::mutex mutex;
+  std::condition_variable_any cv;
+  std::unique_lock lock(mutex);
+  for (bool is_last = false; !is_last;) {
+    // only woken up early by a stop request, at exit, which still gets a last
+    // look for the runs shorter than a period
+    cv.wait_for(lock, stop_token, WATCHDOG_PERIOD, [] { return false; });
+    is_last = stop_token.stop_requested();
+    MemoryStats const stats = get_memory_stats();
+    if (stats.m_peak_rss_kib > limit_kib) {
+      std::println(stderr,
+                   "memory budget exceeded: {:.1f} MiB peak rss over the "
+                   "{} MiB of AOC_MEMORY_LIMIT_MB, aborting",
+                   to_mib(stats.m_peak_rss_kib),
+                   limit_kib / 1024);
+      std::abort();
+    }
+  }
+}
+
+double
+to_mib(u64 kib) {
+  return static_cast<double>(kib) / 1024.0;
+}
+} // namespace
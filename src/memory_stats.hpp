@@ -0,0 +1,40 @@
+#ifndef MEMORY_STATS_HPP
+#define MEMORY_STATS_HPP
+
+#include "utility.hpp" // u64
+
+#include <cstdio> // std::FILE
+
+/// The memory use of this process so far, from getrusage(2) and
+/// /proc/self/status; the sizes are 0 where /proc isn't mounted, but for the
+/// peak RSS that getrusage gives too.
+struct MemoryStats
+{
+  u64 m_peak_rss_kib;
+  u64 m_rss_kib;
+  /// the address space mapped, whether it's resident or not
+  u64 m_mapped_kib;
+  u64 m_peak_mapped_kib;
+  u64 m_minor_faults;
+  /// the faults that had to read a page in from disk
+  u64 m_major_faults;
+};
+
+MemoryStats
+get_memory_stats();
+
+void
+print_memory_stats(std::FILE *stream);
+
+/// forget the peak RSS so far, so that the next one is the peak of what runs
+/// from now on; false when the kernel doesn't support it
+bool
+reset_peak_rss();
+
+/// The hard memory budget: when AOC_MEMORY_LIMIT_MB is set, a thread of its
+/// own checks the peak RSS every few ms and aborts the process with a message
+/// as soon as it exceeds the budget. Does nothing after the first call.
+void
+start_memory_watchdog();
+
+#endif // MEMORY_STATS_HPP
@@ -0,0 +1,227 @@
+#include "model_cache.hpp"
+#include "result_cache.hpp" // Hasher128
+
+#include <array> // std::array
+#include <cstdlib> // std::getenv
+#include <filesystem> // std::filesystem::absolute
+#include <format> // std::format
+#include <print> // std::println
+#include <system_error> // std::error_code
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // stat
+#include <fcntl.h> // open
+#include <unistd.h> // close
+#include <utility> // std::exchange
+
+namespace
+{
+constexpr std::array<char, 8> MAGIC{'A', 'O', 'C', 'M', 'O', 'D', 'E', 'L'};
+/// the version of the header below; each day versions its own payload
+constexpr u32 FORMAT_VERSION{1};
+
+struct ModelHeader
+{
+  std::array<char, 8> m_magic;
+  u32 m_format_version;
+  u32 m_model_version;
+  std::array<char, 8> m_name;
+  u64 m_source_size;
+  i64 m_source_mtime_ns;
+  Hash128 m_source_hash;
+  u64 m_payload_size;
+};
+// keeps the payload that follows aligned for anything it may hold
+static_assert(sizeof(ModelHeader) == 64);
+
+struct SourceStat
+{
+  u64 m_size;
+  i64 m_mtime_ns;
+};
+
+std::optional<SourceStat>
+stat_source(char const *path);
+std::array<char, 8>
+to_name(std::string_view name);
+Hash128
+hash_contents(std::string_view contents);
+bool
+save_model(std::string const &model_path,
+           ModelHeader const &header,
+           std::string_view payload);
+} // namespace
+
+ModelView::ModelView(std::string_view payload) : m_payload(payload) {}
+
+MappedFile::MappedFile(std::string_view data) : m_data(data) {}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : m_data(std::exchange(other.m_data, {})) {}
+
+MappedFile &
+MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    if (!m_data.empty()) {
+      munmap(const_cast<char *>(m_data.data()), m_data.size());
+    }
+    m_data = std::exchange(other.m_data, {});
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  if (!m_data.empty()) {
+    munmap(const_cast<char *>(m_data.data()), m_data.size());
+  }
+}
+
+std::string_view
+MappedFile::data() const {
+  return m_data;
+}
+
+std::optional<MappedFile>
+map_file(char const *path) {
+  int const fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return std::nullopt;
+  }
+  struct stat file_stat{};
+  if (fstat(fd, &file_stat) == -1 || file_stat.st_size <= 0) {
+    close(fd);
+    return std::nullopt;
+  }
+  auto const size = static_cast<std::size_t>(file_stat.st_size);
+  void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping outlives the descriptor
+  close(fd);
+  if (data == MAP_FAILED) {
+    return std::nullopt;
+  }
+  return MappedFile({static_cast<char const *>(data), size});
+}
+
+Model::Model(MappedFile file) : m_file(std::move(file)) {}
+
+Model::Model(std::string payload) : m_payload(std::move(payload)) {}
+
+ModelView
+Model::view() const {
+  if (m_file) {
+    return ModelView(m_file->data().substr(sizeof(ModelHeader)));
+  }
+  return ModelView(m_payload);
+}
+
+std::optional<Model>
+load_model(char const *path,
+           std::string_view name,
+           u32 version,
+           ModelBuilder const &build) {
+  std::optional<SourceStat> const source = stat_source(path);
+  char const *model_dir = std::getenv("AOC_MODEL_DIR");
+  if (!source || model_dir == nullptr || *model_dir == '\0') {
+    std::vector<std::string> const lines = read_input_file(path);
+    if (lines.empty()) {
+      return std::nullopt;
+    }
+    return Model(build(lines));
+  }
+
+  // one model per input file and solver, whatever the input's contents
+  std::string const abs_path = std::filesystem::absolute(path).string();
+  Hasher128 path_hasher;
+  path_hasher.update(abs_path);
+  std::string const model_path = std::format(
+      "{}/{}-{:016x}.model", model_dir, name, path_hasher.finalize().m_low);
+
+  ModelHeader header{.m_magic = MAGIC,
+                     .m_format_version = FORMAT_VERSION,
+                     .m_model_version = version,
+                     .m_name = to_name(name),
+                     .m_source_size = source->m_size,
+                     .m_source_mtime_ns = source->m_mtime_ns,
+                     .m_source_hash = {},
+                     .m_payload_size = 0};
+  std::optional<MappedFile> model_file = map_file(model_path.c_str());
+  ModelHeader cached{};
+  if (model_file && model_file->data().size() >= sizeof(ModelHeader)) {
+    std::memcpy(&cached, model_file->data().data(), sizeof(ModelHeader));
+  }
+  bool const is_current =
+      model_file && cached.m_magic == MAGIC
+      && cached.m_format_version == FORMAT_VERSION
+      && cached.m_model_version == version && cached.m_name == header.m_name
+      && cached.m_payload_size + sizeof(ModelHeader)
+             == model_file->data().size();
+  if (is_current && cached.m_source_size == source->m_size
+      && cached.m_source_mtime_ns == source->m_mtime_ns) {
+    return Model(*std::move(model_file));
+  }
+
+  std::string contents;
+  if (!read_file(path, contents)) {
+    std::println(stderr, "couldn't read file {}", path);
+    return std::nullopt;
+  }
+  header.m_source_hash = hash_contents(contents);
+  if (is_current && cached.m_source_hash == header.m_source_hash) {
+    // only touched: keep the model, under the input's new mtime
+    std::string_view const payload =
+        model_file->data().substr(sizeof(ModelHeader));
+    header.m_payload_size = payload.size();
+    save_model(model_path, header, payload);
+    return Model(*std::move(model_file));
+  }
+
+  std::vector<std::string> const lines = split_lines(contents);
+  if (lines.empty()) {
+    return std::nullopt;
+  }
+  std::string payload = build(lines);
+  header.m_payload_size = payload.size();
+  std::error_code error;
+  std::filesystem::create_directories(model_dir, error);
+  if (!save_model(model_path, header, payload)) {
+    std::println(stderr, "couldn't save the model {}", model_path);
+  }
+  return Model(std::move(payload));
+}
+
+namespace
+{
+std::optional<SourceStat>
+stat_source(char const *path) {
+  struct stat file_stat{};
+  if (stat(path, &file_stat) == -1) {
+    return std::nullopt;
+  }
+  return SourceStat{.m_size = static_cast<u64>(file_stat.st_size),
+                    .m_mtime_ns = (file_stat.st_mtim.tv_sec * 1'000'000'000)
+                                  + file_stat.st_mtim.tv_nsec};
+}
+
+std::array<char, 8>
+to_name(std::string_view name) {
+  std::array<char, 8> ret{};
+  name.copy(ret.data(), ret.size());
+  return ret;
+}
+
+Hash128
+hash_contents(std::string_view contents) {
+  Hasher128 hasher;
+  hasher.update(contents);
+  return hasher.finalize();
+}
+
+bool
+save_model(std::string const &model_path,
+           ModelHeader const &header,
+           std::string_view payload) {
+  std::string model(sizeof(ModelHeader), '\0');
+  std::memcpy(model.data(), &header, sizeof(ModelHeader));
+  model.append(payload);
+  return write_file_atomically(model_path.c_str(), model);
+}
+} // namespace
@@ -0,0 +1,156 @@
+#ifndef MODEL_CACHE_HPP
+#define MODEL_CACHE_HPP
+
+#include "utility.hpp" // u64
+
+#include <cstring> // std::memcpy
+#include <functional> // std::function
+#include <new> // std::launder
+#include <optional> // std::optional
+#include <span> // std::span
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <type_traits> // std::is_trivially_copyable_v
+#include <vector> // std::vector
+
+/// Pre-parsed models: a day whose parsing costs more than its solving can
+/// turn the text input into a compact binary payload once, which later runs
+/// memory-map and read in place, without any deserialization. A payload is a
+/// root struct at offset 0 followed by the arrays it refers to by offset, all
+/// of them trivially copyable and at offsets aligned for their types.
+
+/// Builds a payload.
+class ModelWriter
+{
+public:
+  /// append `value`, returning its offset
+  template <typename T>
+  u64
+  append(T const &value) {
+    return append_array(std::span<T const>(&value, 1));
+  }
+
+  template <typename T>
+  u64
+  append_array(std::span<T const> values) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    u64 const offset = (m_payload.size() + alignof(T) - 1) / alignof(T)
+                       * alignof(T);
+    m_payload.resize(offset + values.size_bytes());
+    if (!values.empty()) {
+      std::memcpy(
+          m_payload.data() + offset, values.data(), values.size_bytes());
+    }
+    return offset;
+  }
+
+  template <typename T>
+  u64
+  append_array(std::vector<T> const &values) {
+    return append_array(std::span<T const>(values));
+  }
+
+  /// replace a value appended earlier, e.g. the root once the offsets of the
+  /// arrays it refers to are known
+  template <typename T>
+  void
+  overwrite(u64 offset, T const &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    ASSERT(offset + sizeof(T) <= m_payload.size());
+    std::memcpy(m_payload.data() + offset, &value, sizeof(T));
+  }
+
+  [[nodiscard]] std::string
+  release() {
+    return std::move(m_payload);
+  }
+
+private:
+  std::string m_payload;
+};
+
+/// Reads a payload in place.
+class ModelView
+{
+public:
+  explicit ModelView(std::string_view payload);
+
+  template <typename T>
+  T const &
+  get(u64 offset) const {
+    return get_array<T>(offset, 1)[0];
+  }
+
+  template <typename T>
+  std::span<T const>
+  get_array(u64 offset, u64 count) const {
+    static_assert(std::is_trivially_copyable_v<T>);
+    ASSERT(offset % alignof(T) == 0);
+    ASSERT(offset + count * sizeof(T) <= m_payload.size());
+    auto const *data =
+        std::launder(reinterpret_cast<T const *>(m_payload.data() + offset));
+    return {data, count};
+  }
+
+private:
+  std::string_view m_payload;
+};
+
+/// A read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+  MappedFile(MappedFile const &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &
+  operator=(MappedFile const &) = delete;
+  MappedFile &
+  operator=(MappedFile &&other) noexcept;
+  ~MappedFile();
+
+  [[nodiscard]] std::string_view
+  data() const;
+
+private:
+  friend std::optional<MappedFile>
+  map_file(char const *path);
+
+  explicit MappedFile(std::string_view data);
+
+  std::string_view m_data;
+};
+
+std::optional<MappedFile>
+map_file(char const *path);
+
+/// A loaded model, either mapped from the model cache or just built.
+class Model
+{
+public:
+  explicit Model(MappedFile file);
+  explicit Model(std::string payload);
+
+  [[nodiscard]] ModelView
+  view() const;
+
+private:
+  std::optional<MappedFile> m_file;
+  std::string m_payload;
+};
+
+using ModelBuilder =
+    std::function<std::string(std::vector<std::string> const &lines)>;
+
+/// The model of the input file at `path`, for the solver named `name`. With
+/// AOC_MODEL_DIR set, the model an earlier run saved there is mapped and used
+/// as long as the input still has the size and mtime it had, or else still
+/// hashes the same, and as long as `version` still matches; otherwise it's
+/// rebuilt from the input's lines and saved for the next run. nullopt when the
+/// input can't be read or is empty.
+std::optional<Model>
+load_model(char const *path,
+           std::string_view name,
+           u32 version,
+           ModelBuilder const &build);
+
+#endif // MODEL_CACHE_HPP
@@ -0,0 +1,43 @@
+#include "profiler.hpp"
+
+#include <print> // std::println
+
+#ifdef AOC_PROFILE
+#include <gperftools/profiler.h> // ProfilerStart
+#endif
+
+ScopedProfiler::ScopedProfiler(std::string path) : m_path(std::move(path)) {
+#ifdef AOC_PROFILE
+  m_is_profiling = ProfilerStart(m_path.c_str()) != 0;
+  if (!m_is_profiling) {
+    std::println(stderr, "couldn't start profiling into {}", m_path);
+  }
+#endif
+}
+
+ScopedProfiler::~ScopedProfiler() {
+#ifdef AOC_PROFILE
+  if (m_is_profiling) {
+    std::size_t const samples = num_samples();
+    ProfilerStop();
+    std::println(stderr, "profile: {} samples written to {}", samples, m_path);
+  }
+#endif
+}
+
+std::size_t
+ScopedProfiler::num_samples() const {
+#ifdef AOC_PROFILE
+  if (m_is_profiling) {
+    ProfilerState state{};
+    ProfilerGetCurrentState(&state);
+    return static_cast<std::size_t>(state.samples_gathered);
+  }
+#endif
+  return 0;
+}
+
+bool
+ScopedProfiler::has_enough_samples() const {
+  return !m_is_profiling || num_samples() >= MIN_SAMPLES;
+}
@@ -0,0 +1,41 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <cstddef> // std::size_t
+#include <string> // std::string
+
+/// A gperftools CPU profile of its scope only, written to `path` on
+/// destruction, so that the profile isn't dominated by the tests, the output
+/// and the setup around the code of interest. Does nothing unless built with
+/// the PROFILE config, which defines AOC_PROFILE and links -lprofiler. Only
+/// one may be live at a time, as the profiler is per process.
+class ScopedProfiler
+{
+public:
+  explicit ScopedProfiler(std::string path);
+  ScopedProfiler(ScopedProfiler const &) = delete;
+  ScopedProfiler(ScopedProfiler &&) = delete;
+  ScopedProfiler &
+  operator=(ScopedProfiler const &) = delete;
+  ScopedProfiler &
+  operator=(ScopedProfiler &&) = delete;
+  ~ScopedProfiler();
+
+  /// the samples taken so far; 0 when not profiling
+  [[nodiscard]] std::size_t
+  num_samples() const;
+
+  /// whether the profile has enough samples to be meaningful; always true
+  /// when not profiling, so that nothing waits on it
+  [[nodiscard]] bool
+  has_enough_samples() const;
+
+private:
+  /// at the default 100 Hz, about 5 s of CPU time
+  static constexpr std::size_t MIN_SAMPLES{500};
+
+  std::string m_path;
+  bool m_is_profiling{false};
+};
+
+#endif // PROFILER_HPP
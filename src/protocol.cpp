@@ -0,0 +1,243 @@
+#include "protocol.hpp"
+
+#include <algorithm> // std::min
+#include <charconv> // std::from_chars
+#include <cerrno> // errno
+#include <cstring> // std::memcpy
+#include <format> // std::format
+#include <sys/socket.h> // socket
+#include <sys/un.h> // sockaddr_un
+#include <unistd.h> // close
+#include <utility> // std::exchange
+
+namespace
+{
+constexpr std::size_t READ_SIZE{64 * 1024};
+
+bool
+make_address(std::string const &path, sockaddr_un &addr) {
+  addr = {};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return false;
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+/// unlike str_to_int(), fails instead of asserting, since the request comes
+/// from the outside
+template <typename T>
+bool
+parse_number(std::string_view sv, T &value) {
+  auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), value);
+  return ec == std::errc() && ptr == sv.data() + sv.size();
+}
+} // namespace
+
+Connection::Connection(int fd) : m_fd(fd) {}
+
+Connection::Connection(Connection &&other) noexcept
+    : m_fd(std::exchange(other.m_fd, -1)),
+      m_buffer(std::move(other.m_buffer)),
+      m_buffer_pos(std::exchange(other.m_buffer_pos, 0)) {}
+
+Connection &
+Connection::operator=(Connection &&other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  if (m_fd != -1) {
+    close(m_fd);
+  }
+  m_fd = std::exchange(other.m_fd, -1);
+  m_buffer = std::move(other.m_buffer);
+  m_buffer_pos = std::exchange(other.m_buffer_pos, 0);
+  return *this;
+}
+
+Connection::~Connection() {
+  if (m_fd != -1) {
+    close(m_fd);
+  }
+}
+
+int
+Connection::fd() const {
+  return m_fd;
+}
+
+bool
+Connection::fill_buffer() {
+  m_buffer.erase(0, m_buffer_pos);
+  m_buffer_pos = 0;
+  std::size_t const old_size = m_buffer.size();
+  m_buffer.resize(old_size + READ_SIZE);
+  ssize_t num_read{};
+  do {
+    num_read = read(m_fd, m_buffer.data() + old_size, READ_SIZE);
+  } while (num_read < 0 && errno == EINTR);
+  m_buffer.resize(old_size
+                  + static_cast<std::size_t>(std::max(num_read, ssize_t{0})));
+  return num_read > 0;
+}
+
+bool
+Connection::read_line(std::string &line) {
+  while (true) {
+    std::size_t const eol = m_buffer.find('\n', m_buffer_pos);
+    if (eol != std::string::npos) {
+      line.assign(m_buffer, m_buffer_pos, eol - m_buffer_pos);
+      m_buffer_pos = eol + 1;
+      return true;
+    }
+    if (!fill_buffer()) {
+      return false;
+    }
+  }
+}
+
+bool
+Connection::read_exact(std::size_t size, std::string &data) {
+  data.clear();
+  while (data.size() < size) {
+    if (m_buffer_pos == m_buffer.size() && !fill_buffer()) {
+      return false;
+    }
+    std::size_t const chunk =
+        std::min(size - data.size(), m_buffer.size() - m_buffer_pos);
+    data.append(m_buffer, m_buffer_pos, chunk);
+    m_buffer_pos += chunk;
+  }
+  return true;
+}
+
+bool
+Connection::write_all(std::string_view data) {
+  while (!data.empty()) {
+    ssize_t const num_written =
+        send(m_fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (num_written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data.remove_prefix(static_cast<std::size_t>(num_written));
+  }
+  return true;
+}
+
+bool
+Connection::send_request(Request const &request) {
+  if (!request.m_inline) {
+    return write_all(std::format("{} {} path {}\n",
+                                 request.m_day,
+                                 request.m_part,
+                                 request.m_input));
+  }
+  return write_all(std::format("{} {} inline {}\n",
+                               request.m_day,
+                               request.m_part,
+                               request.m_input.size()))
+         && write_all(request.m_input);
+}
+
+bool
+Connection::receive_request(Request &request,
+                            std::string &error,
+                            std::size_t max_inline_size) {
+  std::string header;
+  if (!read_line(header)) {
+    return false;
+  }
+  error.clear();
+
+  auto tokens = split(header);
+  if (tokens.size() < 4 || !parse_number(tokens[0], request.m_day)
+      || !parse_number(tokens[1], request.m_part)) {
+    error = std::format("malformed request '{}'", header);
+    return true;
+  }
+  if (tokens[2] == "path") {
+    request.m_inline = false;
+    // the path is the rest of the line, spaces included
+    request.m_input = header.substr(
+        static_cast<std::size_t>(tokens[3].data() - header.data()));
+    return true;
+  }
+  std::size_t size{};
+  if (tokens[2] == "inline" && tokens.size() == 4
+      && parse_number(tokens[3], size) && size <= max_inline_size) {
+    request.m_inline = true;
+    return read_exact(size, request.m_input);
+  }
+  error = std::format("malformed request '{}'", header);
+  return true;
+}
+
+bool
+Connection::send_response(Response const &response) {
+  if (!response.m_ok) {
+    return write_all(std::format("error {}\n", response.m_answer));
+  }
+  return write_all(
+      std::format("ok {} {}\n", response.m_answer, response.m_time_us));
+}
+
+std::optional<Response>
+Connection::receive_response() {
+  std::string line;
+  if (!read_line(line)) {
+    return std::nullopt;
+  }
+  if (line.starts_with("error ")) {
+    return Response{.m_ok = false, .m_answer = line.substr(6), .m_time_us = 0};
+  }
+  auto tokens = split(line);
+  u64 time_us{};
+  if (tokens.size() != 3 || tokens[0] != "ok"
+      || !parse_number(tokens[2], time_us)) {
+    return std::nullopt;
+  }
+  return Response{.m_ok = true,
+                  .m_answer = std::string(tokens[1]),
+                  .m_time_us = time_us};
+}
+
+int
+listen_unix(std::string const &path, int backlog) {
+  sockaddr_un addr{};
+  if (!make_address(path, addr)) {
+    return -1;
+  }
+  int const fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1) {
+    return -1;
+  }
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<sockaddr const *>(&addr), sizeof(addr)) == -1
+      || listen(fd, backlog) == -1) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+std::optional<Connection>
+connect_unix(std::string const &path) {
+  sockaddr_un addr{};
+  if (!make_address(path, addr)) {
+    return std::nullopt;
+  }
+  int const fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1) {
+    return std::nullopt;
+  }
+  if (connect(fd, reinterpret_cast<sockaddr const *>(&addr), sizeof(addr))
+      == -1) {
+    close(fd);
+    return std::nullopt;
+  }
+  return Connection(fd);
+}
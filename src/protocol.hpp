@@ -0,0 +1,90 @@
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include "utility.hpp" // u64
+
+#include <optional> // std::optional
+#include <string> // std::string
+#include <string_view> // std::string_view
+
+/// The aocd wire protocol, spoken over a Unix domain stream socket. A
+/// connection carries any number of requests, each answered before the next
+/// one is read. A request is a header line, followed by the input itself when
+/// it is sent inline:
+///   <day> <part> path <input path>\n
+///   <day> <part> inline <payload size>\n<payload>
+/// and a response is a single line:
+///   ok <answer> <solve time in us>\n
+///   error <message>\n
+struct Request
+{
+  u8 m_day;
+  u8 m_part;
+  bool m_inline;
+  /// the input's path, or the input itself when it is sent inline
+  std::string m_input;
+};
+
+struct Response
+{
+  bool m_ok;
+  /// the answer, or the error message when !m_ok
+  std::string m_answer;
+  u64 m_time_us;
+};
+
+/// An owned stream socket with buffered reads.
+class Connection
+{
+public:
+  explicit Connection(int fd);
+  Connection(Connection const &) = delete;
+  Connection(Connection &&other) noexcept;
+  Connection &
+  operator=(Connection const &) = delete;
+  Connection &
+  operator=(Connection &&other) noexcept;
+  ~Connection();
+
+  [[nodiscard]] int
+  fd() const;
+
+  /// read up to the next '\n', which is dropped; false on EOF or error
+  bool
+  read_line(std::string &line);
+  bool
+  read_exact(std::size_t size, std::string &data);
+  bool
+  write_all(std::string_view data);
+
+  bool
+  send_request(Request const &request);
+  /// false on EOF; a malformed request, or an inline one whose payload is
+  /// larger than `max_inline_size`, is reported through `error`, after which
+  /// the rest of the stream can't be trusted
+  bool
+  receive_request(Request &request,
+                  std::string &error,
+                  std::size_t max_inline_size);
+  bool
+  send_response(Response const &response);
+  std::optional<Response>
+  receive_response();
+
+private:
+  int m_fd;
+  std::string m_buffer;
+  std::size_t m_buffer_pos{0};
+
+  bool
+  fill_buffer();
+};
+
+/// bind and listen on `path`, replacing a stale socket file; -1 on error
+int
+listen_unix(std::string const &path, int backlog);
+
+std::optional<Connection>
+connect_unix(std::string const &path);
+
+#endif // PROTOCOL_HPP
@@ -0,0 +1,349 @@
+#include "result_cache.hpp"
+#include "source_hash.hpp" // AOC_SOURCE_HASH
+
+#include <algorithm> // std::ranges::sort
+#include <bit> // std::rotl
+#include <cstdlib> // std::getenv
+#include <cstring> // std::memcpy
+#include <format> // std::format
+#include <memory> // std::unique_ptr
+#include <print> // std::println
+#include <system_error> // std::error_code
+
+namespace
+{
+constexpr u64 C1{0x87c3'7b91'1142'53d5};
+constexpr u64 C2{0x4cf5'ad43'2745'937f};
+constexpr u64 DEFAULT_MAX_BYTES{64 * 1024 * 1024};
+/// what an entry is charged against the size cap: the file system block it
+/// occupies, as the answer itself is only a few bytes
+constexpr u64 ENTRY_BYTES{4096};
+/// an eviction frees up to this fraction of the cap, so that it doesn't have
+/// to scan the directory again on the very next store
+constexpr u64 EVICT_TO_PERCENT{90};
+
+u64
+fmix(u64 k) {
+  k ^= k >> 33;
+  k *= 0xff51'afd7'ed55'8ccd;
+  k ^= k >> 33;
+  k *= 0xc4ce'b9fe'1a85'ec53;
+  k ^= k >> 33;
+  return k;
+}
+
+u64
+mix_k1(u64 k1) {
+  return std::rotl(k1 * C1, 31) * C2;
+}
+
+u64
+mix_k2(u64 k2) {
+  return std::rotl(k2 * C2, 33) * C1;
+}
+
+bool
+is_temp_file(std::filesystem::path const &path) {
+  return path.filename().string().starts_with('.');
+}
+
+/// the hash_input() of the lines of the input file, which is read and
+/// decompressed a chunk at a time; nullopt when it can't be
+std::optional<Hash128>
+hash_input_file(char const *path) {
+  Hasher128 hasher;
+  if (!for_each_input_line(path, [&hasher](std::string_view line) {
+        hasher.update(line);
+        hasher.update("\n");
+      })) {
+    return std::nullopt;
+  }
+  return hasher.finalize();
+}
+
+/// the hash_input() of split_lines(contents), without splitting them: every
+/// line but the last ends in its '\n' already
+Hash128
+hash_input_contents(std::string_view contents) {
+  Hasher128 hasher;
+  hasher.update(contents);
+  if (!contents.empty() && contents.back() != '\n') {
+    hasher.update("\n");
+  }
+  return hasher.finalize();
+}
+
+/// solve the decompressed contents of an input file; nullopt when they're
+/// empty
+std::optional<std::string>
+solve_contents(Solver const &solver, std::string_view contents) {
+  std::vector<std::string> const lines = split_lines(contents);
+  if (lines.empty()) {
+    return std::nullopt;
+  }
+  return solver.m_solve(lines);
+}
+} // namespace
+
+Hasher128::Hasher128(u64 seed) : m_h1(seed), m_h2(seed) {}
+
+void
+Hasher128::process_block(char const *block) {
+  u64 k1{};
+  u64 k2{};
+  std::memcpy(&k1, block, sizeof(k1));
+  std::memcpy(&k2, block + sizeof(k1), sizeof(k2));
+
+  m_h1 ^= mix_k1(k1);
+  m_h1 = std::rotl(m_h1, 27) + m_h2;
+  m_h1 = m_h1 * 5 + 0x52dc'e729;
+  m_h2 ^= mix_k2(k2);
+  m_h2 = std::rotl(m_h2, 31) + m_h1;
+  m_h2 = m_h2 * 5 + 0x3849'5ab5;
+}
+
+void
+Hasher128::update(std::string_view data) {
+  m_length += data.size();
+  if (m_tail_size != 0) {
+    std::size_t const num_copied =
+        std::min(BLOCK_SIZE - m_tail_size, data.size());
+    std::memcpy(m_tail.data() + m_tail_size, data.data(), num_copied);
+    m_tail_size += num_copied;
+    data.remove_prefix(num_copied);
+    if (m_tail_size < BLOCK_SIZE) {
+      return;
+    }
+    process_block(m_tail.data());
+    m_tail_size = 0;
+  }
+  for (; data.size() >= BLOCK_SIZE; data.remove_prefix(BLOCK_SIZE)) {
+    process_block(data.data());
+  }
+  std::memcpy(m_tail.data(), data.data(), data.size());
+  m_tail_size = data.size();
+}
+
+Hash128
+Hasher128::finalize() const {
+  std::array<char, BLOCK_SIZE> tail{};
+  std::memcpy(tail.data(), m_tail.data(), m_tail_size);
+  u64 k1{};
+  u64 k2{};
+  std::memcpy(&k1, tail.data(), sizeof(k1));
+  std::memcpy(&k2, tail.data() + sizeof(k1), sizeof(k2));
+  // a zero k1 or k2 mixes to zero, so the short tails need no special case
+  u64 h1 = m_h1 ^ mix_k1(k1) ^ m_length;
+  u64 h2 = m_h2 ^ mix_k2(k2) ^ m_length;
+
+  h1 += h2;
+  h2 += h1;
+  h1 = fmix(h1);
+  h2 = fmix(h2);
+  h1 += h2;
+  h2 += h1;
+  return {.m_low = h1, .m_high = h2};
+}
+
+bool
+operator==(Hash128 const &lhs, Hash128 const &rhs) {
+  return lhs.m_low == rhs.m_low && lhs.m_high == rhs.m_high;
+}
+
+Hash128
+hash_input(std::vector<std::string> const &lines) {
+  Hasher128 hasher;
+  for (std::string const &line : lines) {
+    hasher.update(line);
+    hasher.update("\n");
+  }
+  return hasher.finalize();
+}
+
+ResultCache::ResultCache(std::filesystem::path dir, u64 max_bytes)
+    : m_dir(std::move(dir)), m_max_bytes(max_bytes) {
+  std::error_code error;
+  std::filesystem::create_directories(m_dir, error);
+  u64 num_entries{};
+  for (auto const &entry : std::filesystem::directory_iterator(m_dir, error)) {
+    num_entries += is_temp_file(entry.path()) ? u64{0} : u64{1};
+  }
+  m_bytes.store(num_entries * ENTRY_BYTES);
+}
+
+std::filesystem::path
+ResultCache::get_entry_path(Solver const &solver, Hash128 hash) const {
+  return m_dir
+         / std::format("{}-{}-{:016x}{:016x}",
+                       get_solver_name(solver),
+                       AOC_SOURCE_HASH,
+                       hash.m_high,
+                       hash.m_low);
+}
+
+std::optional<std::string>
+ResultCache::lookup(Solver const &solver, Hash128 hash) {
+  std::filesystem::path const path = get_entry_path(solver, hash);
+  std::string answer;
+  if (!read_file(path.c_str(), answer) || answer.empty()) {
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+  }
+  // the mtime is the entry's last use, for the LRU eviction
+  std::error_code error;
+  std::filesystem::last_write_time(
+      path, std::filesystem::file_time_type::clock::now(), error);
+  m_hits.fetch_add(1, std::memory_order_relaxed);
+  return answer;
+}
+
+void
+ResultCache::store(Solver const &solver,
+                   Hash128 hash,
+                   std::string_view answer) {
+  if (!write_file_atomically(get_entry_path(solver, hash).c_str(), answer)) {
+    return;
+  }
+  m_stores.fetch_add(1, std::memory_order_relaxed);
+  if (m_bytes.fetch_add(ENTRY_BYTES) + ENTRY_BYTES > m_max_bytes) {
+    evict();
+  }
+}
+
+void
+ResultCache::evict() {
+  std::unique_lock const lock(m_evict_mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    // another thread is already on it
+    return;
+  }
+
+  struct Entry
+  {
+    std::filesystem::path m_path;
+    std::filesystem::file_time_type m_last_use;
+  };
+  std::vector<Entry> entries;
+  std::error_code error;
+  for (auto const &entry : std::filesystem::directory_iterator(m_dir, error)) {
+    if (!is_temp_file(entry.path())) {
+      entries.emplace_back(entry.path(), entry.last_write_time(error));
+    }
+  }
+  std::ranges::sort(entries, {}, &Entry::m_last_use);
+
+  u64 const target_bytes = m_max_bytes / 100 * EVICT_TO_PERCENT;
+  u64 bytes = entries.size() * ENTRY_BYTES;
+  for (auto it = entries.begin(); it != entries.end() && bytes > target_bytes;
+       ++it) {
+    // an entry that another process evicted first still frees its space
+    std::filesystem::remove(it->m_path, error);
+    bytes -= ENTRY_BYTES;
+    m_evictions.fetch_add(1, std::memory_order_relaxed);
+  }
+  m_bytes.store(bytes);
+}
+
+ResultCache::Stats
+ResultCache::get_stats() const {
+  return {.m_hits = m_hits.load(),
+          .m_misses = m_misses.load(),
+          .m_stores = m_stores.load(),
+          .m_evictions = m_evictions.load()};
+}
+
+void
+ResultCache::print_stats(std::FILE *stream) const {
+  Stats const stats = get_stats();
+  u64 const num_lookups = stats.m_hits + stats.m_misses;
+  std::println(stream,
+               "result cache: {} hits, {} misses ({:.1f}% hit rate), {} "
+               "stores, {} evictions, ~{} KiB in {}",
+               stats.m_hits,
+               stats.m_misses,
+               num_lookups == 0 ? 0.0
+                                : 100.0 * static_cast<double>(stats.m_hits)
+                                      / static_cast<double>(num_lookups),
+               stats.m_stores,
+               stats.m_evictions,
+               m_bytes.load() / 1024,
+               m_dir.string());
+}
+
+ResultCache *
+default_result_cache() {
+  static std::unique_ptr<ResultCache> cache = []() {
+    char const *dir = std::getenv("AOC_CACHE_DIR");
+    if (dir == nullptr || *dir == '\0') {
+      return std::unique_ptr<ResultCache>();
+    }
+    u64 max_bytes = DEFAULT_MAX_BYTES;
+    if (char const *env = std::getenv("AOC_CACHE_MAX_BYTES")) {
+      std::string_view const sv{env};
+      if (!sv.empty() && std::ranges::all_of(sv, is_digit)) {
+        max_bytes = str_to_int<u64>(sv);
+      }
+    }
+    return std::make_unique<ResultCache>(dir, max_bytes);
+  }();
+  return cache.get();
+}
+
+std::string
+cached_solve(Solver const &solver, std::vector<std::string> const &lines) {
+  ResultCache *cache = default_result_cache();
+  if (cache == nullptr) {
+    return solver.m_solve(lines);
+  }
+  Hash128 const hash = hash_input(lines);
+  if (std::optional<std::string> answer = cache->lookup(solver, hash)) {
+    return *std::move(answer);
+  }
+  std::string answer = solver.m_solve(lines);
+  cache->store(solver, hash, answer);
+  return answer;
+}
+
+std::optional<std::string>
+cached_solve_file(Solver const &solver, char const *path) {
+  ResultCache *cache = default_result_cache();
+  if (cache == nullptr) {
+    if (solver.m_solve_file) {
+      return solver.m_solve_file(path);
+    }
+    std::string contents;
+    if (!read_file(path, contents)) {
+      std::println(stderr, "couldn't read file {}", path);
+      return std::nullopt;
+    }
+    return solve_contents(solver, contents);
+  }
+
+  // the key is the hash of the decompressed lines, as cached_solve() has it
+  // for the same input, however it's compressed. A solver with an
+  // m_solve_file reads the file itself on a miss, so it's only hashed here, in
+  // memory bounded by a chunk; the others get the contents read along the
+  // way, which are only split into lines on a miss
+  std::string contents;
+  std::optional<Hash128> hash;
+  if (solver.m_solve_file) {
+    hash = hash_input_file(path);
+  } else if (read_file(path, contents)) {
+    hash = hash_input_contents(contents);
+  } else {
+    std::println(stderr, "couldn't read file {}", path);
+  }
+  if (!hash) {
+    return std::nullopt;
+  }
+  if (std::optional<std::string> answer = cache->lookup(solver, *hash)) {
+    return answer;
+  }
+  std::optional<std::string> answer =
+      solver.m_solve_file ? solver.m_solve_file(path)
+                          : solve_contents(solver, contents);
+  if (answer) {
+    cache->store(solver, *hash, *answer);
+  }
+  return answer;
+}
@@ -0,0 +1,124 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include "solver.hpp" // Solver
+#include "utility.hpp" // u64
+
+#include <array> // std::array
+#include <atomic> // std::atomic
+#include <cstdio> // std::FILE
+#include <filesystem> // std::filesystem::path
+#include <mutex> // std::mutex
+#include <optional> // std::optional
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <vector> // std::vector
+
+struct Hash128
+{
+  u64 m_low;
+  u64 m_high;
+};
+
+bool
+operator==(Hash128 const &lhs, Hash128 const &rhs);
+
+/// Streaming MurmurHash3 x64_128: fast and non-cryptographic, which is all a
+/// cache key for inputs we solve ourselves needs. Feeding the data in pieces
+/// gives the same hash as feeding it at once.
+class Hasher128
+{
+public:
+  explicit Hasher128(u64 seed = 0);
+
+  void
+  update(std::string_view data);
+  [[nodiscard]] Hash128
+  finalize() const;
+
+private:
+  static constexpr std::size_t BLOCK_SIZE{16};
+
+  u64 m_h1;
+  u64 m_h2;
+  u64 m_length{0};
+  std::array<char, BLOCK_SIZE> m_tail{};
+  std::size_t m_tail_size{0};
+
+  void
+  process_block(char const *block);
+};
+
+/// the hash of every line followed by a '\n', which is the hash of the input
+/// file itself when it ends with a newline
+Hash128
+hash_input(std::vector<std::string> const &lines);
+
+/// An on-disk cache of (solver, input hash) -> answer, one small file per
+/// entry, that may be shared by any number of processes. The entries are also
+/// keyed on the hash of the sources the solvers were built from, so that a
+/// rebuild with a fixed solver never serves the answers of the broken one.
+/// Entries are written atomically, so a reader sees either the whole answer or
+/// nothing. A hit refreshes the entry's mtime, and once the cache outgrows its
+/// size cap the least recently used entries are evicted.
+class ResultCache
+{
+public:
+  struct Stats
+  {
+    u64 m_hits;
+    u64 m_misses;
+    u64 m_stores;
+    u64 m_evictions;
+  };
+
+  ResultCache(std::filesystem::path dir, u64 max_bytes);
+
+  std::optional<std::string>
+  lookup(Solver const &solver, Hash128 hash);
+  void
+  store(Solver const &solver, Hash128 hash, std::string_view answer);
+
+  [[nodiscard]] Stats
+  get_stats() const;
+  void
+  print_stats(std::FILE *stream) const;
+
+private:
+  std::filesystem::path m_dir;
+  u64 m_max_bytes;
+  /// this process' estimate of the cache's size, corrected by every eviction
+  /// scan since other processes write to the same directory
+  std::atomic<u64> m_bytes{0};
+  std::mutex m_evict_mutex;
+  std::atomic<u64> m_hits{0};
+  std::atomic<u64> m_misses{0};
+  std::atomic<u64> m_stores{0};
+  std::atomic<u64> m_evictions{0};
+
+  [[nodiscard]] std::filesystem::path
+  get_entry_path(Solver const &solver, Hash128 hash) const;
+  void
+  evict();
+};
+
+/// the process-wide cache in the AOC_CACHE_DIR directory, capped at
+/// AOC_CACHE_MAX_BYTES (64 MiB by default); nullptr when AOC_CACHE_DIR isn't
+/// set
+ResultCache *
+default_result_cache();
+
+/// solve the input, or look its answer up in the default cache when there is
+/// one
+std::string
+cached_solve(Solver const &solver, std::vector<std::string> const &lines);
+
+/// like cached_solve(), for an input file, which goes to the solver's
+/// m_solve_file when it has one; nullopt when the file can't be read or is
+/// empty. The key is the hash_input() of the file's decompressed lines, the
+/// same as cached_solve()'s for the same input, so a hit costs one read of the
+/// file, and it's only split into lines on a miss.
+std::optional<std::string>
+cached_solve_file(Solver const &solver, char const *path);
+
+#endif // RESULT_CACHE_HPP
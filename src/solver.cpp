@@ -0,0 +1,348 @@
+#include "solver.hpp"
+#include "async_reader.hpp" // AsyncReader
+#include "memory_stats.hpp" // start_memory_watchdog
+#include "profiler.hpp" // ScopedProfiler
+#include "result_cache.hpp" // cached_solve
+#include "task_scheduler.hpp" // default_scheduler
+#include "utility.hpp" // for_each_input_line, for_each_line, split_lines
+#include "watch.hpp" // watch_input
+
+#include <algorithm> // std::ranges::sort
+#include <chrono> // std::chrono::steady_clock
+#include <cstdio> // std::fflush
+#include <filesystem> // std::filesystem::directory_iterator
+#include <format> // std::format
+#include <libassert/assert.hpp> // libassert::set_failure_handler
+#include <map> // std::map
+#include <mutex> // std::mutex
+#include <print> // std::println
+#include <span> // std::span
+
+namespace
+{
+std::vector<Solver> &
+get_registry() {
+  static std::vector<Solver> registry;
+  return registry;
+}
+
+struct BatchResult
+{
+  std::optional<std::string> m_answer;
+  u64 m_us{};
+};
+
+std::vector<std::filesystem::path>
+get_batch_inputs(std::span<char const *const> args);
+int
+run_batch(Solver const &solver, std::span<char const *const> args);
+int
+run_repeated(Solver const &solver,
+             std::string_view num_solves_arg,
+             char const *path);
+/// the solver's profile, e.g. "d05p2.prof", in the current directory
+std::string
+get_profile_path(Solver const &solver);
+void
+print_cache_stats();
+u64
+to_us(std::chrono::steady_clock::duration duration);
+} // namespace
+
+SolverRegistrar::SolverRegistrar(Solver solver) {
+  std::vector<Solver> &registry = get_registry();
+  registry.emplace_back(std::move(solver));
+  std::ranges::sort(registry, {}, [](Solver const &solver_) {
+    return std::pair{solver_.m_day, solver_.m_part};
+  });
+}
+
+std::optional<std::string>
+accumulate_input_file(char const *path, Accumulator &accumulator) {
+  bool is_empty = true;
+  if (!for_each_input_line(path, [&](std::string_view line) {
+        accumulator.add_line(line);
+        is_empty = false;
+      })
+      || is_empty) {
+    return std::nullopt;
+  }
+  return accumulator.answer();
+}
+
+std::optional<std::string>
+accumulate_input(std::istream &input, Accumulator &accumulator) {
+  bool is_empty = true;
+  if (!for_each_line(input,
+                     [&](std::string_view line) {
+                       accumulator.add_line(line);
+                       is_empty = false;
+                     })
+      || is_empty) {
+    return std::nullopt;
+  }
+  return accumulator.answer();
+}
+
+void
+throw_on_solver_failures() {
+  libassert::set_failure_handler([](libassert::assertion_info const &info) {
+    throw SolverFailure(info.to_string(0, libassert::color_scheme::blank));
+  });
+}
+
+std::vector<Solver> const &
+get_solvers() {
+  return get_registry();
+}
+
+Solver const *
+find_solver(std::uint8_t day, std::uint8_t part) {
+  auto find_it = std::ranges::find_if(get_solvers(), [&](Solver const &solver) {
+    return solver.m_day == day && solver.m_part == part;
+  });
+  if (find_it == get_solvers().end()) {
+    return nullptr;
+  }
+  return &*find_it;
+}
+
+std::string
+get_solver_name(Solver const &solver) {
+  return std::format("d{:02}p{}", solver.m_day, solver.m_part);
+}
+
+bool
+is_selected(Solver const &solver, std::span<char const *const> selection) {
+  if (selection.empty()) {
+    return true;
+  }
+  std::string const name = get_solver_name(solver);
+  return std::ranges::any_of(selection, [&](std::string_view selected) {
+    return selected == name || selected == name.substr(0, 3)
+           || (std::ranges::all_of(selected, is_digit)
+               && str_to_int<unsigned>(selected) == solver.m_day);
+  });
+}
+
+int
+solver_main(int argc,
+            char const *const *argv,
+            std::uint8_t day,
+            std::uint8_t part) {
+  Solver const *solver = find_solver(day, part);
+  ASSERT(solver != nullptr);
+  start_memory_watchdog();
+  solver->m_tests();
+
+  auto args = std::span(argv, std::size_t(argc));
+  if (args.size() >= 2 && std::string_view(args[1]) == "--batch") {
+    return run_batch(*solver, args.subspan(2));
+  }
+  if (args.size() == 3 && std::string_view(args[1]) == "--watch") {
+    if (!solver->m_make_accumulator) {
+      std::println(stderr, "{} has no --watch mode", get_solver_name(*solver));
+      return 1;
+    }
+    return watch_input(*solver, args[2]);
+  }
+  if (args.size() == 4 && std::string_view(args[1]) == "--repeat") {
+    return run_repeated(*solver, args[2], args[3]);
+  }
+
+  if (args.size() != 2) {
+    std::println(stderr,
+                 "usage: {0} input.txt\n"
+                 "       {0} --batch (file|dir)...\n"
+                 "       {0} --watch input.txt\n"
+                 "       {0} --repeat N input.txt",
+                 args[0]);
+    return 1;
+  }
+  std::optional<std::string> answer;
+  {
+    ScopedProfiler const profiler(get_profile_path(*solver));
+    answer = cached_solve_file(*solver, args[1]);
+  }
+  if (!answer) {
+    return 1;
+  }
+  std::println("{}", *answer);
+  return 0;
+}
+
+int
+embedded_main(int argc,
+               char const *const *argv,
+               std::uint8_t day,
+               std::uint8_t part,
+               std::string_view answer,
+               std::string_view input) {
+  auto args = std::span(argv, std::size_t(argc));
+  bool const verify =
+      args.size() == 2 && std::string_view(args[1]) == "--verify";
+  if (args.size() != 1 && !verify) {
+    std::println(stderr, "usage: {} [--verify]", args[0]);
+    return 1;
+  }
+  if (verify) {
+    Solver const *solver = find_solver(day, part);
+    ASSERT(solver != nullptr);
+    solver->m_tests();
+    std::string const runtime_answer = solver->m_solve(split_lines(input));
+    if (runtime_answer != answer) {
+      std::println(stderr,
+                   "{}: compile-time answer {} but run-time answer {}",
+                   get_solver_name(*solver),
+                   answer,
+                   runtime_answer);
+      return 1;
+    }
+  }
+  std::println("{}", answer);
+  return 0;
+}
+
+namespace
+{
+std::vector<std::filesystem::path>
+get_batch_inputs(std::span<char const *const> args) {
+  std::vector<std::filesystem::path> inputs;
+  for (std::filesystem::path const arg : args) {
+    if (!std::filesystem::is_directory(arg)) {
+      inputs.emplace_back(arg);
+      continue;
+    }
+    std::vector<std::filesystem::path> dir_inputs;
+    for (auto const &entry : std::filesystem::directory_iterator(arg)) {
+      if (entry.is_regular_file()) {
+        dir_inputs.emplace_back(entry.path());
+      }
+    }
+    std::ranges::sort(dir_inputs);
+    append_range(inputs, dir_inputs);
+  }
+  return inputs;
+}
+
+int
+run_batch(Solver const &solver, std::span<char const *const> args) {
+  std::vector<std::filesystem::path> const inputs = get_batch_inputs(args);
+  if (inputs.empty()) {
+    std::println(stderr,
+                 "usage: {} --batch (file|dir)...",
+                 get_solver_name(solver));
+    return 1;
+  }
+
+  // the inputs are solved in whatever order their reads complete in, and
+  // each result is printed as soon as those of every input before it are:
+  // only the results that wait on an earlier input are held. Every input is
+  // read whole here, even for a solver with an m_solve_file: what that saves
+  // is reading a single file whole, and the reads here overlap the solves
+  // instead
+  std::mutex print_mutex;
+  std::map<std::size_t, BatchResult> pending_results;
+  std::size_t num_printed{};
+  int ret_val = 0;
+  AsyncReader reader(default_scheduler());
+  reader.read_all(
+      inputs,
+      [&](std::size_t idx, std::optional<std::string_view> contents) {
+        BatchResult result;
+        if (contents) {
+          auto const start = std::chrono::steady_clock::now();
+          if (std::vector<std::string> const lines = split_lines(*contents);
+              !lines.empty()) {
+            result.m_answer = cached_solve(solver, lines);
+            result.m_us = to_us(std::chrono::steady_clock::now() - start);
+          }
+        }
+
+        std::lock_guard const lock(print_mutex);
+        pending_results.emplace(idx, std::move(result));
+        for (auto it = pending_results.begin();
+             it != pending_results.end() && it->first == num_printed;
+             it = pending_results.erase(it), ++num_printed) {
+          if (it->second.m_answer) {
+            std::println("{}\t{}\t{}",
+                         inputs[it->first].string(),
+                         *it->second.m_answer,
+                         it->second.m_us);
+          } else {
+            std::println("{}\t-\t-", inputs[it->first].string());
+            ret_val = 1;
+          }
+        }
+        std::fflush(stdout);
+      });
+
+  print_cache_stats();
+  reader.print_stats(stderr);
+  print_memory_stats(stderr);
+  return ret_val;
+}
+
+int
+run_repeated(Solver const &solver,
+             std::string_view num_solves_arg,
+             char const *path) {
+  if (num_solves_arg.empty() || !std::ranges::all_of(num_solves_arg, is_digit)
+      || str_to_int<u64>(num_solves_arg) == 0) {
+    std::println(stderr,
+                 "usage: {} --repeat N input.txt",
+                 get_solver_name(solver));
+    return 1;
+  }
+  u64 const min_solves = str_to_int<u64>(num_solves_arg);
+  std::string contents;
+  if (!read_file(path, contents)) {
+    std::println(stderr, "couldn't read file {}", path);
+    return 1;
+  }
+  std::vector<std::string> const lines = split_lines(contents);
+  if (lines.empty()) {
+    return 1;
+  }
+
+  // straight to the solve, bypassing the caches, which would make every
+  // solve but the first one a lookup
+  std::string answer;
+  u64 num_solves = 0;
+  auto const start = std::chrono::steady_clock::now();
+  {
+    ScopedProfiler const profiler(get_profile_path(solver));
+    // past N solves until the profile has enough samples, when profiling
+    while (num_solves < min_solves || !profiler.has_enough_samples()) {
+      answer = solver.m_solve(lines);
+      ++num_solves;
+    }
+  }
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+  std::println("{}", answer);
+  std::println(stderr,
+               "{} solves, {:.3f} us each",
+               num_solves,
+               static_cast<double>(to_us(elapsed))
+                   / static_cast<double>(num_solves));
+  return 0;
+}
+
+std::string
+get_profile_path(Solver const &solver) {
+  return std::format("{}.prof", get_solver_name(solver));
+}
+
+void
+print_cache_stats() {
+  if (ResultCache const *cache = default_result_cache()) {
+    cache->print_stats(stderr);
+  }
+}
+
+u64
+to_us(std::chrono::steady_clock::duration duration) {
+  return static_cast<u64>(
+      std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+} // namespace
@@ -0,0 +1,192 @@
+#ifndef SOLVER_HPP
+#define SOLVER_HPP
+
+#include <cstdint> // std::uint8_t
+#include <format> // std::format
+#include <functional> // std::function
+#include <iosfwd> // std::istream
+#include <memory> // std::unique_ptr
+#include <optional> // std::optional
+#include <random> // std::mt19937_64
+#include <span> // std::span
+#include <stdexcept> // std::runtime_error
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <type_traits> // std::invoke_result_t
+#include <vector> // std::vector
+
+/// Incremental solving of an append-only input, for --watch: the lines are fed
+/// in order as they are appended, and the answer so far is available after
+/// any of them.
+class Accumulator
+{
+public:
+  Accumulator() = default;
+  Accumulator(Accumulator const &) = delete;
+  Accumulator(Accumulator &&) = delete;
+  Accumulator &
+  operator=(Accumulator const &) = delete;
+  Accumulator &
+  operator=(Accumulator &&) = delete;
+  virtual ~Accumulator() = default;
+
+  virtual void
+  add_line(std::string_view line) = 0;
+  [[nodiscard]] virtual std::string
+  answer() const = 0;
+};
+
+/// the Accumulator of the days whose answer is a sum over independent lines
+template <typename F>
+class LineSumAccumulator : public Accumulator
+{
+public:
+  explicit LineSumAccumulator(F line_value)
+      : m_line_value(std::move(line_value)) {}
+
+  void
+  add_line(std::string_view line) override {
+    m_sum += m_line_value(line);
+  }
+  [[nodiscard]] std::string
+  answer() const override {
+    return std::format("{}", m_sum);
+  }
+
+private:
+  F m_line_value;
+  std::invoke_result_t<F &, std::string_view> m_sum{};
+};
+
+template <typename F>
+std::unique_ptr<Accumulator>
+make_line_sum_accumulator(F line_value) {
+  return std::make_unique<LineSumAccumulator<F>>(std::move(line_value));
+}
+
+/// feed every line of the input file at `path` to `accumulator`, a chunk at a
+/// time, for the m_solve_file of the days that stream their input; nullopt
+/// when the file can't be read, or is empty as an m_solve is never given an
+/// empty input
+std::optional<std::string>
+accumulate_input_file(char const *path, Accumulator &accumulator);
+
+/// like accumulate_input_file(), on a stream of uncompressed lines, e.g. a
+/// test's std::istringstream
+std::optional<std::string>
+accumulate_input(std::istream &input, Accumulator &accumulator);
+
+/// a failed ASSERT or UNREACHABLE, once throw_on_solver_failures() is in
+/// effect; what() is libassert's report of it
+class SolverFailure : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+/// Make every failed assertion in this process throw a SolverFailure instead
+/// of aborting, for the hosts that solve the inputs of others in-process (aocd
+/// and the C API): an input that breaks a solver's assumptions then fails its
+/// own request, and the solve unwinds like any other exception would.
+void
+throw_on_solver_failures();
+
+/// how the running time of a solve grows with the size of its input
+enum class Complexity : std::uint8_t
+{
+  UNKNOWN,
+  CONSTANT,
+  LOGARITHMIC,
+  LINEAR,
+  N_LOG_N,
+  QUADRATIC,
+  CUBIC
+};
+
+/// A day's part as seen by the drivers that run solvers in-process. Every
+/// dNNpM translation unit registers one through a SolverRegistrar.
+struct Solver
+{
+  std::uint8_t m_day;
+  std::uint8_t m_part;
+  void (*m_tests)();
+  std::function<std::string(std::vector<std::string> const &)> m_solve;
+  /// solve straight from the input file, for the days that cache their
+  /// parsed model (see model_cache.hpp), scan the file's bytes as they are or
+  /// stream it; nullopt when the file can't be read or is empty. --batch
+  /// reads its inputs itself and solves them with m_solve.
+  std::function<std::optional<std::string>(char const *path)> m_solve_file{};
+  /// for the days whose input may be an append-only log (see --watch)
+  std::function<std::unique_ptr<Accumulator>()> m_make_accumulator{};
+  /// for the days with an optimized solve: the simpler solve it replaced,
+  /// kept as the oracle that aoc_diff checks it against
+  std::function<std::string(std::vector<std::string> const &)> m_reference{};
+  /// a random input of about `size` elements, for aoc_diff and aoc_scaling
+  std::function<std::vector<std::string>(std::mt19937_64 &rng,
+                                         std::size_t size)>
+      m_generate{};
+  /// the budget of the solve in the `size` of m_generate's inputs, which
+  /// aoc_scaling checks the measured growth of its running time against
+  Complexity m_complexity{Complexity::UNKNOWN};
+};
+
+class SolverRegistrar
+{
+public:
+  explicit SolverRegistrar(Solver solver);
+};
+
+/// all registered solvers, ordered by day and part
+std::vector<Solver> const &
+get_solvers();
+
+Solver const *
+find_solver(std::uint8_t day, std::uint8_t part);
+
+/// the solver's binary name, e.g. "d05p2"
+std::string
+get_solver_name(Solver const &solver);
+
+/// whether the solver is one of `selection`, which names days (e.g. `5` or
+/// `d05`) or parts (e.g. `d05p2`); an empty selection selects every solver
+bool
+is_selected(Solver const &solver, std::span<char const *const> selection);
+
+/// The main() of every dNNpM binary:
+///   dNNpM input.txt               solve a single input
+///   dNNpM --batch (file|dir)...   solve every input (a directory stands for
+///                                 the files in it) in this one process and
+///                                 print one "file<TAB>answer<TAB>time_us"
+///                                 line per input
+///   dNNpM --watch input.txt       follow an append-only input and print the
+///                                 updated answer whenever complete lines are
+///                                 appended to it (the days with an
+///                                 Accumulator only)
+///   dNNpM --repeat N input.txt    solve the input N times, bypassing the
+///                                 caches, and print the time per solve
+/// But for --repeat, the answers go through the result cache when
+/// AOC_CACHE_DIR is set (see result_cache.hpp). The process aborts once its
+/// peak RSS exceeds AOC_MEMORY_LIMIT_MB when that's set (see
+/// memory_stats.hpp). In a PROFILE build, only the solves are profiled, into
+/// dNNpM.prof (see profiler.hpp), and --repeat goes on past N solves until the
+/// profile has enough samples.
+int
+solver_main(int argc,
+            char const *const *argv,
+            std::uint8_t day,
+            std::uint8_t part);
+
+/// The main() of a dNNpM_embedded binary (see AOC_EMBED_INPUT_DIR), whose
+/// input was embedded and solved at compile time:
+///   dNNpM_embedded            print the `answer` the compiler found
+///   dNNpM_embedded --verify   also solve the embedded `input` at run time,
+///                             and fail unless both answers agree
+int
+embedded_main(int argc,
+              char const *const *argv,
+              std::uint8_t day,
+              std::uint8_t part,
+              std::string_view answer,
+              std::string_view input);
+
+#endif // SOLVER_HPP
@@ -0,0 +1,271 @@
+#include "task_scheduler.hpp"
+
+#include <algorithm> // std::max
+#include <charconv> // std::from_chars
+#include <cstdlib> // std::getenv
+#include <print> // std::println
+#include <string_view> // std::string_view
+#include <system_error> // std::errc
+#include <utility> // std::exchange
+
+namespace
+{
+/// the most workers AOC_THREADS may ask for, far more than any machine this
+/// runs on has hardware threads
+constexpr std::size_t MAX_THREADS{1024};
+
+struct CurrentWorker
+{
+  TaskScheduler const *m_scheduler;
+  std::size_t m_idx;
+};
+
+thread_local CurrentWorker current_worker{.m_scheduler = nullptr, .m_idx = 0};
+
+u64
+to_ns(std::chrono::steady_clock::duration duration) {
+  return static_cast<u64>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+
+/// the number of workers AOC_THREADS asks for, or the hardware concurrency
+/// when it isn't set, or isn't a number from 1 to MAX_THREADS
+std::size_t
+get_default_num_workers() {
+  std::size_t const hardware_threads{std::thread::hardware_concurrency()};
+  char const *env = std::getenv("AOC_THREADS");
+  if (env == nullptr) {
+    return hardware_threads;
+  }
+  std::string_view const sv{env};
+  std::size_t num_threads{};
+  auto [ptr, ec] =
+      std::from_chars(sv.data(), sv.data() + sv.size(), num_threads);
+  if (ec != std::errc() || ptr != sv.data() + sv.size() || num_threads == 0
+      || num_threads > MAX_THREADS) {
+    std::println(stderr,
+                 "AOC_THREADS='{}' isn't a number of threads from 1 to {}, "
+                 "using the {} hardware threads",
+                 sv,
+                 MAX_THREADS,
+                 hardware_threads);
+    return hardware_threads;
+  }
+  return num_threads;
+}
+} // namespace
+
+TaskScheduler::TaskScheduler(std::size_t num_workers)
+    : m_num_workers(std::max<std::size_t>(num_workers, 1)),
+      m_start(std::chrono::steady_clock::now()) {
+  // the extra slot collects the stats of non-worker threads
+  for (std::size_t idx = 0; idx < m_num_workers + 1; ++idx) {
+    m_workers.emplace_back(std::make_unique<Worker>());
+  }
+  for (std::size_t idx = 0; idx < m_num_workers; ++idx) {
+    m_threads.emplace_back([this, idx] { worker_loop(idx); });
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  {
+    std::lock_guard const lock(m_sleep_mutex);
+    m_stop = true;
+  }
+  m_sleep_cv.notify_all();
+  m_threads.clear();
+}
+
+std::size_t
+TaskScheduler::num_workers() const {
+  return m_num_workers;
+}
+
+void
+TaskScheduler::submit(Task task) {
+  std::size_t worker_idx = get_current_worker_idx();
+  if (worker_idx == num_workers()) {
+    worker_idx = m_next_worker.fetch_add(1, std::memory_order_relaxed)
+                 % num_workers();
+  }
+  {
+    Worker &worker = *m_workers[worker_idx];
+    std::lock_guard const lock(worker.m_mutex);
+    worker.m_tasks.emplace_back(std::move(task));
+  }
+  m_queued.fetch_add(1, std::memory_order_release);
+  // taking the lock orders the increment against a worker that is about to
+  // fall asleep, so the notification can't be lost
+  {
+    std::lock_guard const lock(m_sleep_mutex);
+  }
+  m_sleep_cv.notify_one();
+}
+
+void
+TaskScheduler::run_until(std::function<bool()> const &done) {
+  std::size_t const worker_idx = get_current_worker_idx();
+  while (!done()) {
+    if (try_run_one(worker_idx)) {
+      continue;
+    }
+    auto const idle_start = std::chrono::steady_clock::now();
+    std::this_thread::yield();
+    m_workers[worker_idx]->m_idle_ns.fetch_add(
+        to_ns(std::chrono::steady_clock::now() - idle_start),
+        std::memory_order_relaxed);
+  }
+}
+
+TaskScheduler::Stats
+TaskScheduler::get_stats() const {
+  Stats stats{.m_workers = {},
+              .m_elapsed = std::chrono::steady_clock::now() - m_start};
+  for (auto const &worker : m_workers) {
+    stats.m_workers.emplace_back(
+        worker->m_executed.load(std::memory_order_relaxed),
+        worker->m_steals.load(std::memory_order_relaxed),
+        std::chrono::nanoseconds(
+            worker->m_idle_ns.load(std::memory_order_relaxed)));
+  }
+  return stats;
+}
+
+void
+TaskScheduler::print_stats(std::FILE *stream) const {
+  Stats const stats = get_stats();
+  auto const elapsed_ns = static_cast<double>(stats.m_elapsed.count());
+
+  u64 total_executed{};
+  u64 total_steals{};
+  for (WorkerStats const &worker : stats.m_workers) {
+    total_executed += worker.m_executed;
+    total_steals += worker.m_steals;
+  }
+  std::println(stream,
+               "scheduler: {} workers, {} tasks, {} steals, {:.3f} ms elapsed",
+               num_workers(),
+               total_executed,
+               total_steals,
+               elapsed_ns / 1e6);
+  std::println(stream,
+               "{:>8} {:>10} {:>10} {:>12}",
+               "worker",
+               "tasks",
+               "steals",
+               "utilization");
+  for (std::size_t idx = 0; idx < num_workers(); ++idx) {
+    WorkerStats const &worker = stats.m_workers[idx];
+    double const idle_ns = static_cast<double>(worker.m_idle.count());
+    std::println(stream,
+                 "{:>8} {:>10} {:>10} {:>11.1f}%",
+                 idx,
+                 worker.m_executed,
+                 worker.m_steals,
+                 100.0 * std::max(0.0, 1.0 - (idle_ns / elapsed_ns)));
+  }
+  WorkerStats const &external = stats.m_workers.back();
+  std::println(stream,
+               "{:>8} {:>10} {:>10} {:>12}",
+               "external",
+               external.m_executed,
+               external.m_steals,
+               "-");
+}
+
+void
+TaskScheduler::worker_loop(std::size_t worker_idx) {
+  current_worker = {.m_scheduler = this, .m_idx = worker_idx};
+  Worker &worker = *m_workers[worker_idx];
+  while (true) {
+    if (try_run_one(worker_idx)) {
+      continue;
+    }
+
+    auto const idle_start = std::chrono::steady_clock::now();
+    std::unique_lock lock(m_sleep_mutex);
+    m_sleep_cv.wait(lock, [this] {
+      return m_stop || m_queued.load(std::memory_order_acquire) != 0;
+    });
+    bool const stop = m_stop && m_queued.load(std::memory_order_acquire) == 0;
+    lock.unlock();
+    worker.m_idle_ns.fetch_add(to_ns(std::chrono::steady_clock::now()
+                                     - idle_start),
+                               std::memory_order_relaxed);
+    if (stop) {
+      return;
+    }
+  }
+}
+
+bool
+TaskScheduler::try_run_one(std::size_t worker_idx) {
+  if (m_queued.load(std::memory_order_acquire) == 0) {
+    return false;
+  }
+
+  Task task;
+  bool stolen = false;
+  if (worker_idx < num_workers()) {
+    Worker &own = *m_workers[worker_idx];
+    std::lock_guard const lock(own.m_mutex);
+    if (!own.m_tasks.empty()) {
+      task = std::move(own.m_tasks.back());
+      own.m_tasks.pop_back();
+    }
+  }
+  // steal from the other workers, starting next to ourselves so that the
+  // thieves spread over the victims
+  for (std::size_t offset = 1; !task && offset <= num_workers(); ++offset) {
+    Worker &victim = *m_workers[(worker_idx + offset) % num_workers()];
+    std::lock_guard const lock(victim.m_mutex);
+    if (!victim.m_tasks.empty()) {
+      task = std::move(victim.m_tasks.front());
+      victim.m_tasks.pop_front();
+      stolen = true;
+    }
+  }
+  if (!task) {
+    return false;
+  }
+
+  m_queued.fetch_sub(1, std::memory_order_acq_rel);
+  Worker &worker = *m_workers[worker_idx];
+  if (stolen) {
+    worker.m_steals.fetch_add(1, std::memory_order_relaxed);
+  }
+  task();
+  worker.m_executed.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+std::size_t
+TaskScheduler::get_current_worker_idx() const {
+  if (current_worker.m_scheduler == this) {
+    return current_worker.m_idx;
+  }
+  return num_workers();
+}
+
+TaskScheduler &
+default_scheduler() {
+  static TaskScheduler scheduler(get_default_num_workers());
+  return scheduler;
+}
+
+TaskGroup::TaskGroup(TaskScheduler &scheduler) : m_scheduler(scheduler) {}
+
+TaskGroup::~TaskGroup() {
+  m_scheduler.run_until(
+      [this] { return m_pending.load(std::memory_order_acquire) == 0; });
+}
+
+void
+TaskGroup::wait() {
+  m_scheduler.run_until(
+      [this] { return m_pending.load(std::memory_order_acquire) == 0; });
+  std::lock_guard const lock(m_exception_mutex);
+  if (m_exception) {
+    std::rethrow_exception(std::exchange(m_exception, nullptr));
+  }
+}
@@ -0,0 +1,148 @@
+#ifndef TASK_SCHEDULER_HPP
+#define TASK_SCHEDULER_HPP
+
+#include "utility.hpp" // u64
+
+#include <atomic> // std::atomic
+#include <chrono> // std::chrono::nanoseconds
+#include <condition_variable> // std::condition_variable
+#include <cstdio> // std::FILE
+#include <deque> // std::deque
+#include <exception> // std::exception_ptr
+#include <functional> // std::function
+#include <memory> // std::unique_ptr
+#include <mutex> // std::mutex
+#include <thread> // std::jthread
+#include <vector> // std::vector
+
+/// A fork/join task scheduler with one deque per worker. A worker pushes and
+/// pops its own tasks at the back of its deque (newest first, which keeps
+/// nested spawns cache friendly) and, once it runs dry, steals the oldest task
+/// from the front of another worker's deque. Tasks whose cost varies by orders
+/// of magnitude are thus balanced at run time instead of by a static split.
+class TaskScheduler
+{
+public:
+  using Task = std::function<void()>;
+
+  struct WorkerStats
+  {
+    u64 m_executed;
+    u64 m_steals;
+    std::chrono::nanoseconds m_idle;
+  };
+
+  struct Stats
+  {
+    /// one entry per worker, plus a last one for the non-worker threads that
+    /// help out while they wait on a TaskGroup
+    std::vector<WorkerStats> m_workers;
+    std::chrono::nanoseconds m_elapsed;
+  };
+
+  explicit TaskScheduler(std::size_t num_workers);
+  TaskScheduler(TaskScheduler const &) = delete;
+  TaskScheduler(TaskScheduler &&) = delete;
+  TaskScheduler &
+  operator=(TaskScheduler const &) = delete;
+  TaskScheduler &
+  operator=(TaskScheduler &&) = delete;
+  ~TaskScheduler();
+
+  [[nodiscard]] std::size_t
+  num_workers() const;
+
+  /// queue a task on the calling worker's deque, or round-robin over the
+  /// workers when called from outside the scheduler
+  void
+  submit(Task task);
+
+  /// run queued tasks on the calling thread until `done()` returns true
+  void
+  run_until(std::function<bool()> const &done);
+
+  [[nodiscard]] Stats
+  get_stats() const;
+
+  void
+  print_stats(std::FILE *stream) const;
+
+private:
+  struct alignas(64) Worker
+  {
+    std::mutex m_mutex;
+    std::deque<Task> m_tasks;
+    std::atomic<u64> m_executed;
+    std::atomic<u64> m_steals;
+    std::atomic<u64> m_idle_ns;
+  };
+
+  std::size_t m_num_workers;
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::atomic<std::size_t> m_queued{0};
+  std::atomic<std::size_t> m_next_worker{0};
+  std::mutex m_sleep_mutex;
+  std::condition_variable m_sleep_cv;
+  bool m_stop{false};
+  std::chrono::steady_clock::time_point m_start;
+  std::vector<std::jthread> m_threads;
+
+  void
+  worker_loop(std::size_t worker_idx);
+  bool
+  try_run_one(std::size_t worker_idx);
+  std::size_t
+  get_current_worker_idx() const;
+};
+
+/// the process-wide scheduler; sized by the AOC_THREADS environment variable
+/// when set, otherwise, or with a warning when it isn't a number of threads
+/// from 1 to 1024, by the hardware concurrency
+TaskScheduler &
+default_scheduler();
+
+/// Fork/join on top of a TaskScheduler: spawn() forks a child task and wait()
+/// joins all of them. The waiting thread runs queued tasks in the meantime, so
+/// a task may itself spawn and wait on a nested group without deadlocking.
+class TaskGroup
+{
+public:
+  explicit TaskGroup(TaskScheduler &scheduler);
+  TaskGroup(TaskGroup const &) = delete;
+  TaskGroup(TaskGroup &&) = delete;
+  TaskGroup &
+  operator=(TaskGroup const &) = delete;
+  TaskGroup &
+  operator=(TaskGroup &&) = delete;
+  ~TaskGroup();
+
+  template <typename F>
+  void
+  spawn(F &&func) {
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    m_scheduler.submit([this, func = std::forward<F>(func)]() mutable {
+      try {
+        func();
+      } catch (...) {
+        std::lock_guard const lock(m_exception_mutex);
+        if (!m_exception) {
+          m_exception = std::current_exception();
+        }
+      }
+      m_pending.fetch_sub(1, std::memory_order_acq_rel);
+    });
+  }
+
+  /// block until every spawned task has finished; rethrows the first
+  /// exception thrown by any of them
+  void
+  wait();
+
+private:
+  TaskScheduler &m_scheduler;
+  std::atomic<std::size_t> m_pending{0};
+  std::mutex m_exception_mutex;
+  std::exception_ptr m_exception;
+};
+
+#endif // TASK_SCHEDULER_HPP
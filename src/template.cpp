@@ -1,6 +1,7 @@
+#include "solver.hpp" // SolverRegistrar, solver_main
 #include "utility.hpp"
 
-#include <print> // std::println
+#include <format> // std::format
 
 namespace
 {
@@ -10,13 +11,23 @@ u64
 get_num_lines(std::vector<std::string> const &lines);
 } // namespace
 
+#ifndef AOC_NO_MAIN
 int
 main(int argc, char const **argv) {
-  tests();
-  std::vector<std::string> lines = read_program_input(argc, argv);
-  std::println("{}", get_num_lines(lines));
-  return 0;
+  return solver_main(argc, argv, 0, 0);
 }
+#endif
+
+namespace
+{
+SolverRegistrar const registrar{
+    {.m_day = 0,
+     .m_part = 0,
+     .m_tests = tests,
+     .m_solve = [](std::vector<std::string> const &lines) {
+       return std::format("{}", get_num_lines(lines));
+     }}};
+} // namespace
 
 namespace
 {
@@ -1,57 +1,45 @@
 #include "utility.hpp"
+#include "decompression.hpp" // DecompressionStream
+#include <atomic> // std::atomic
+#include <filesystem> // std::filesystem::rename
+#include <format> // std::format
 #include <fstream> // std::ifstream
+#include <istream> // std::istream
 #include <print> // std::println
+#include <unistd.h> // getpid
 #include <vector> // std::vector
 
+namespace
+{
 bool
-is_digit(char ch) {
-  return ch >= '0' && ch <= '9';
-}
+read_compressed_input_file(char const *path,
+                           Compression compression,
+                           std::vector<std::string> &lines);
 
-uint8_t
-char_to_int(char ch) {
-  return static_cast<uint8_t>(ch - '0');
-}
+/// the chunks in which for_each_input_line() reads an uncompressed input
+constexpr std::size_t LINE_CHUNK_SIZE{256 * 1024};
 
-std::vector<std::string_view>
-split(std::string_view sv, std::string_view delim) {
-  std::vector<std::string_view> tokens;
-  for (std::size_t right = sv.find(delim); right != std::string_view::npos;
-       right = sv.find(delim)) {
-    if (right == 0) {
-      sv = sv.substr(right + delim.size());
-      continue;
+/// call `on_line` with every line that ends in the chunk, `partial_line`
+/// being the start of the first one, read from the chunks before; the chunk's
+/// unfinished last line is left in `partial_line`
+void
+split_chunk(std::string_view chunk,
+            std::string &partial_line,
+            std::function<void(std::string_view)> const &on_line) {
+  for (std::size_t eol = chunk.find('\n'); eol != std::string_view::npos;
+       eol = chunk.find('\n')) {
+    if (partial_line.empty()) {
+      on_line(chunk.substr(0, eol));
+    } else {
+      partial_line.append(chunk.substr(0, eol));
+      on_line(partial_line);
+      partial_line.clear();
     }
-    tokens.emplace_back(sv.substr(0, right));
-    sv = sv.substr(right + delim.size());
-  }
-  if (!sv.empty()) {
-    tokens.emplace_back(sv);
-  }
-  return tokens;
-}
-
-std::uint8_t
-get_num_digits(u64 num) {
-  if (num == 0) {
-    return 1;
-  }
-  std::uint8_t num_digits{};
-  while (num != 0) {
-    ++num_digits;
-    num /= 10;
+    chunk.remove_prefix(eol + 1);
   }
-  return num_digits;
-}
-
-u64
-pow10(std::uint8_t exp) {
-  u64 val{1};
-  for (std::uint8_t i{0}; i < exp; ++i) {
-    val *= 10;
-  }
-  return val;
+  partial_line.append(chunk);
 }
+} // namespace
 
 bool
 operator==(Location const &lhs, Location const &rhs) {
@@ -69,22 +57,185 @@ std::hash<Location>::operator()(Location const &loc) const noexcept {
 }
 
 std::vector<std::string>
-read_program_input(int argc, char const * const *argv) {
-  auto args = std::span(argv, size_t(argc));
-  if (args.size() != 2) {
-    std::println(stderr, "usage: {} input.txt", args[0]);
-    return {};
+read_input_file(char const *path) {
+  std::vector<std::string> lines;
+  read_input_file(path, lines);
+  return lines;
+}
+
+bool
+read_input_file(char const *path, std::vector<std::string> &lines) {
+  Compression const compression = detect_file_compression(path);
+  if (compression != Compression::NONE) {
+    return read_compressed_input_file(path, compression, lines);
   }
 
-  std::ifstream infile(args[1]);
+  std::ifstream infile(path);
   if (!infile.is_open()) {
-    std::println(stderr, "couldn't open file {}", args[1]);
-    return {};
+    std::println(stderr, "couldn't open file {}", path);
+    lines.clear();
+    return false;
   }
 
-  std::vector<std::string> lines;
-  for (std::string line; std::getline(infile, line);) {
-    lines.emplace_back(std::move(line));
+  std::size_t num_lines = 0;
+  for (;; ++num_lines) {
+    if (num_lines == lines.size()) {
+      lines.emplace_back();
+    }
+    if (!std::getline(infile, lines[num_lines])) {
+      break;
+    }
   }
-  return lines;
+  lines.resize(num_lines);
+  return true;
+}
+
+bool
+for_each_line(std::istream &input,
+              std::function<void(std::string_view)> const &on_line) {
+  std::string partial_line;
+  std::string chunk(LINE_CHUNK_SIZE, '\0');
+  while (input.read(chunk.data(), static_cast<std::streamsize>(chunk.size()))
+         || input.gcount() > 0) {
+    split_chunk(std::string_view(chunk).substr(
+                    0, static_cast<std::size_t>(input.gcount())),
+                partial_line,
+                on_line);
+  }
+  if (!partial_line.empty()) {
+    on_line(partial_line);
+  }
+  return !input.bad();
+}
+
+bool
+for_each_input_line(char const *path,
+                    std::function<void(std::string_view)> const &on_line) {
+  Compression const compression = detect_file_compression(path);
+  if (compression == Compression::NONE) {
+    std::ifstream infile(path, std::ios::binary);
+    if (!infile.is_open()) {
+      std::println(stderr, "couldn't open file {}", path);
+      return false;
+    }
+    return for_each_line(infile, on_line);
+  }
+
+  std::string partial_line;
+  DecompressionStream stream(path, compression);
+  std::string chunk;
+  while (stream.next(chunk)) {
+    split_chunk(chunk, partial_line, on_line);
+  }
+  if (!stream.ok()) {
+    std::println(stderr,
+                 "couldn't decompress the {} file {}",
+                 get_compression_name(compression),
+                 path);
+    return false;
+  }
+  if (!partial_line.empty()) {
+    on_line(partial_line);
+  }
+  return true;
+}
+
+bool
+read_file(char const *path, std::string &contents) {
+  std::ifstream infile(path, std::ios::binary | std::ios::ate);
+  if (!infile.is_open()) {
+    return false;
+  }
+  contents.resize(static_cast<std::size_t>(infile.tellg()));
+  infile.seekg(0);
+  auto const size = static_cast<std::streamsize>(contents.size());
+  if (!infile.read(contents.data(), size)) {
+    return false;
+  }
+  Compression const compression = detect_compression(contents);
+  if (compression == Compression::NONE) {
+    return true;
+  }
+  std::string decompressed;
+  if (!decompress(contents, compression, decompressed)) {
+    std::println(stderr,
+                 "couldn't decompress the {} file {}",
+                 get_compression_name(compression),
+                 path);
+    return false;
+  }
+  contents = std::move(decompressed);
+  return true;
+}
+
+bool
+write_file_atomically(char const *path, std::string_view contents) {
+  static std::atomic<u64> num_temp_files{0};
+  std::filesystem::path const final_path{path};
+  std::filesystem::path const temp_path =
+      final_path.parent_path()
+      / std::format(".{}.{}.{}",
+                    final_path.filename().string(),
+                    getpid(),
+                    num_temp_files.fetch_add(1));
+
+  std::error_code error;
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    auto const size = static_cast<std::streamsize>(contents.size());
+    if (!file.write(contents.data(), size) || !file.flush()) {
+      std::filesystem::remove(temp_path, error);
+      return false;
+    }
+  }
+  std::filesystem::rename(temp_path, final_path, error);
+  if (error) {
+    std::filesystem::remove(temp_path, error);
+    return false;
+  }
+  return true;
+}
+
+namespace
+{
+bool
+read_compressed_input_file(char const *path,
+                           Compression compression,
+                           std::vector<std::string> &lines) {
+  // the lines are split off the chunks while the next ones are decoded
+  DecompressionStream stream(path, compression);
+  std::size_t num_lines = 0;
+  bool in_line = false;
+  std::string chunk;
+  while (stream.next(chunk)) {
+    std::string_view rest = chunk;
+    while (!rest.empty()) {
+      if (!in_line) {
+        if (num_lines == lines.size()) {
+          lines.emplace_back();
+        }
+        lines[num_lines].clear();
+        in_line = true;
+      }
+      std::size_t const eol = rest.find('\n');
+      lines[num_lines].append(rest.substr(0, eol));
+      if (eol == std::string_view::npos) {
+        break;
+      }
+      rest.remove_prefix(eol + 1);
+      ++num_lines;
+      in_line = false;
+    }
+  }
+  lines.resize(in_line ? num_lines + 1 : num_lines);
+  if (!stream.ok()) {
+    std::println(stderr,
+                 "couldn't decompress the {} file {}",
+                 get_compression_name(compression),
+                 path);
+    lines.clear();
+    return false;
+  }
+  return true;
 }
+} // namespace
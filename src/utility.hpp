@@ -1,36 +1,99 @@
 #ifndef UTILITY_HPP
 #define UTILITY_HPP
 
+#include <bit> // std::bit_width
 #include <charconv> // std::from_chars
 #include <cstdint> // std::uint64_t
+#include <functional> // std::function
+#include <iosfwd> // std::istream
 #include <libassert/assert.hpp> // UNREACHABLE
+#include <string> // std::string
 #include <string_view> // std::string_view
+#include <type_traits> // std::is_signed_v
 #include <vector> // std::vector
 
 using u64 = std::uint64_t;
+using u32 = std::uint32_t;
 using u8 = std::uint8_t;
+using i64 = std::int64_t;
 
-bool
-is_digit(char ch);
+// the parsing helpers are constexpr, for the solvers that may solve an
+// embedded input at compile time (see AOC_EMBED_INPUT_DIR)
+
+constexpr bool
+is_digit(char ch) {
+  return ch >= '0' && ch <= '9';
+}
 
-uint8_t
-char_to_int(char ch);
+constexpr uint8_t
+char_to_int(char ch) {
+  return static_cast<uint8_t>(ch - '0');
+}
 
 template <typename T>
-T
+constexpr T
 str_to_int(std::string_view sv) {
-  T result{};
-  auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), result);
-
-  if (ec == std::errc()) {
-    return result;
+  if consteval {
+    // like std::from_chars: an optional '-' for a signed T, then digits
+    T result{};
+    bool const is_negative = std::is_signed_v<T> && sv.starts_with('-');
+    if (is_negative) {
+      sv.remove_prefix(1);
+    }
+    if (sv.empty() || !is_digit(sv[0])) {
+      UNREACHABLE();
+    }
+    for (char const ch : sv) {
+      if (!is_digit(ch)) {
+        break;
+      }
+      result = static_cast<T>((result * 10) + char_to_int(ch));
+    }
+    return is_negative ? static_cast<T>(-result) : result;
+  } else {
+    T result{};
+    auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), result);
+
+    if (ec == std::errc()) {
+      return result;
+    }
+
+    UNREACHABLE();
   }
+}
 
-  UNREACHABLE();
+constexpr std::vector<std::string_view>
+split(std::string_view sv, std::string_view delim = " ") {
+  std::vector<std::string_view> tokens;
+  for (std::size_t right = sv.find(delim); right != std::string_view::npos;
+       right = sv.find(delim)) {
+    if (right == 0) {
+      sv = sv.substr(right + delim.size());
+      continue;
+    }
+    tokens.emplace_back(sv.substr(0, right));
+    sv = sv.substr(right + delim.size());
+  }
+  if (!sv.empty()) {
+    tokens.emplace_back(sv);
+  }
+  return tokens;
 }
 
-std::vector<std::string_view>
-split(std::string_view sv, std::string_view delim = " ");
+/// split a whole input held in memory into lines, the way std::getline would
+constexpr std::vector<std::string>
+split_lines(std::string_view buffer) {
+  std::vector<std::string> lines;
+  while (!buffer.empty()) {
+    std::size_t const eol = buffer.find('\n');
+    lines.emplace_back(buffer.substr(0, eol));
+    if (eol == std::string_view::npos) {
+      break;
+    }
+    buffer.remove_prefix(eol + 1);
+  }
+  return lines;
+}
 
 template<typename T>
 void
@@ -38,11 +101,44 @@ append_range(std::vector<T> &dst, std::vector<T> const &src) {
   dst.insert(dst.end(), src.cbegin(), src.cend());
 }
 
-std::uint8_t
-get_num_digits(u64 num);
+constexpr std::uint8_t
+get_num_digits(u64 num) {
+  if (num == 0) {
+    return 1;
+  }
+  std::uint8_t num_digits{};
+  while (num != 0) {
+    ++num_digits;
+    num /= 10;
+  }
+  return num_digits;
+}
 
-u64
-pow10(std::uint8_t exp);
+constexpr u64
+pow10(std::uint8_t exp) {
+  u64 val{1};
+  for (std::uint8_t i{0}; i < exp; ++i) {
+    val *= 10;
+  }
+  return val;
+}
+
+/// floor(sqrt(num)), exact where going through a double isn't
+constexpr u64
+isqrt(u64 num) {
+  if (num < 2) {
+    return num;
+  }
+  // Newton's method, from a power of two at or above the root
+  u64 root = u64{1} << ((std::bit_width(num) + 1) / 2);
+  while (true) {
+    u64 const next = (root + (num / root)) / 2;
+    if (next >= root) {
+      return root;
+    }
+    root = next;
+  }
+}
 
 struct Location
 {
@@ -101,7 +197,38 @@ struct std::hash<std::pair<T, U>>
   }
 };
 
+/// the lines of the input file; one starting with the gzip or zstd magic bytes
+/// is decompressed on the fly, see decompression.hpp
 std::vector<std::string>
-read_program_input(int argc, char const * const *argv);
+read_input_file(char const *path);
+
+/// like read_input_file(), but reuses the strings already in `lines`, so that
+/// reading many inputs in a row doesn't reallocate every line
+bool
+read_input_file(char const *path, std::vector<std::string> &lines);
+
+/// call `on_line` with every line of the input, which is read, and
+/// decompressed, a chunk at a time: only a chunk and the line it ends in are
+/// ever in memory; false if it can't be read
+bool
+for_each_input_line(char const *path,
+                    std::function<void(std::string_view)> const &on_line);
+
+/// like for_each_input_line(), on a stream of uncompressed lines, e.g. a test's
+/// std::istringstream; false on a read error
+bool
+for_each_line(std::istream &input,
+              std::function<void(std::string_view)> const &on_line);
+
+/// read a whole file into `contents`, unsplit and decompressed; false if it
+/// can't be read
+bool
+read_file(char const *path, std::string &contents);
+
+/// write `contents` to a temporary file next to `path` and rename it into
+/// place, so that concurrent readers see either the old file or the whole new
+/// one; the temporary file's name starts with a '.'
+bool
+write_file_atomically(char const *path, std::string_view contents);
 
 #endif // UTILITY_HPP
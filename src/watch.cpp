@@ -0,0 +1,159 @@
+#include "watch.hpp"
+#include "decompression.hpp" // detect_file_compression
+#include "utility.hpp" // u64
+
+#include <array> // std::array
+#include <cerrno> // errno
+#include <cstdio> // std::fflush
+#include <cstring> // std::memcpy
+#include <fcntl.h> // open
+#include <memory> // std::unique_ptr
+#include <print> // std::println
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <sys/inotify.h> // inotify_init1
+#include <sys/stat.h> // fstat
+#include <unistd.h> // pread
+#include <vector> // std::vector
+
+namespace
+{
+constexpr std::size_t READ_SIZE{64 * 1024};
+
+struct WatchState
+{
+  std::unique_ptr<Accumulator> m_accumulator;
+  /// the offset of the first byte not read yet
+  u64 m_offset;
+  /// the last line read, until its '\n' is appended
+  std::string m_partial_line;
+};
+
+/// feed the complete lines appended since the last call; the number of lines
+/// fed, or -1 on a read error
+ssize_t
+read_appended_lines(int fd, WatchState &state, std::vector<char> &buffer);
+/// block until the input changes; false once it's gone
+bool
+wait_for_change(int notify_fd);
+} // namespace
+
+int
+watch_input(Solver const &solver, char const *path) {
+  if (Compression const compression = detect_file_compression(path);
+      compression != Compression::NONE) {
+    // the appended bytes wouldn't decode on their own
+    std::println(stderr,
+                 "can't watch the {} file {}",
+                 get_compression_name(compression),
+                 path);
+    return 1;
+  }
+  int const notify_fd = inotify_init1(IN_CLOEXEC);
+  // watch before the first read, so that no append can slip in between
+  if (notify_fd == -1
+      || inotify_add_watch(notify_fd,
+                           path,
+                           IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF
+                               | IN_MOVE_SELF)
+             == -1) {
+    std::println(stderr, "couldn't watch file {}", path);
+    return 1;
+  }
+  int const fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    std::println(stderr, "couldn't open file {}", path);
+    close(notify_fd);
+    return 1;
+  }
+
+  WatchState state{.m_accumulator = solver.m_make_accumulator(),
+                   .m_offset = 0,
+                   .m_partial_line = {}};
+  std::vector<char> buffer(READ_SIZE);
+  int ret_val = 0;
+  do {
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) == -1 || file_stat.st_nlink == 0) {
+      // removed: as we hold it open, IN_DELETE_SELF won't come
+      break;
+    }
+    if (static_cast<u64>(file_stat.st_size) < state.m_offset) {
+      std::println(stderr, "{} was truncated, starting over", path);
+      state = {.m_accumulator = solver.m_make_accumulator(),
+               .m_offset = 0,
+               .m_partial_line = {}};
+    }
+
+    ssize_t const num_lines = read_appended_lines(fd, state, buffer);
+    if (num_lines < 0) {
+      std::println(stderr, "couldn't read file {}", path);
+      ret_val = 1;
+      break;
+    }
+    if (num_lines > 0) {
+      std::println("{}", state.m_accumulator->answer());
+      std::fflush(stdout);
+    }
+  } while (wait_for_change(notify_fd));
+
+  close(fd);
+  close(notify_fd);
+  return ret_val;
+}
+
+namespace
+{
+ssize_t
+read_appended_lines(int fd, WatchState &state, std::vector<char> &buffer) {
+  ssize_t num_lines{};
+  while (true) {
+    ssize_t const num_read = pread(
+        fd, buffer.data(), buffer.size(), static_cast<off_t>(state.m_offset));
+    if (num_read < 0 && errno == EINTR) {
+      continue;
+    }
+    if (num_read <= 0) {
+      return num_read < 0 ? -1 : num_lines;
+    }
+    state.m_offset += static_cast<u64>(num_read);
+
+    std::string_view data(buffer.data(), static_cast<std::size_t>(num_read));
+    for (std::size_t eol = data.find('\n'); eol != std::string_view::npos;
+         eol = data.find('\n')) {
+      if (state.m_partial_line.empty()) {
+        state.m_accumulator->add_line(data.substr(0, eol));
+      } else {
+        state.m_partial_line.append(data.substr(0, eol));
+        state.m_accumulator->add_line(state.m_partial_line);
+        state.m_partial_line.clear();
+      }
+      data.remove_prefix(eol + 1);
+      ++num_lines;
+    }
+    state.m_partial_line.append(data);
+  }
+}
+
+bool
+wait_for_change(int notify_fd) {
+  alignas(inotify_event) std::array<char, 4096> events{};
+  ssize_t num_read{};
+  do {
+    num_read = read(notify_fd, events.data(), events.size());
+  } while (num_read < 0 && errno == EINTR);
+  if (num_read <= 0) {
+    return false;
+  }
+
+  for (std::size_t pos = 0; pos < static_cast<std::size_t>(num_read);) {
+    inotify_event event{};
+    std::memcpy(&event, events.data() + pos, sizeof(event));
+    if ((event.mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) != 0) {
+      return false;
+    }
+    pos += sizeof(event) + event.len;
+  }
+  return true;
+}
+} // namespace
@@ -0,0 +1,15 @@
+#ifndef WATCH_HPP
+#define WATCH_HPP
+
+#include "solver.hpp" // Solver
+
+/// Follow the append-only input at `path`: feed the complete lines already in
+/// it, then every complete line appended to it, to a fresh accumulator of the
+/// solver, and print the updated answer after each batch of new lines. Only
+/// the offset of the first unread byte and the unterminated last line are
+/// kept between batches. A truncated input is solved again from the start;
+/// returns once the input is removed or renamed away.
+int
+watch_input(Solver const &solver, char const *path);
+
+#endif // WATCH_HPP